@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * requests, round trips and flushes are counted against the operation that
+ * caused them, the enum trace_op in progress or the one that last changed
+ * the window a render operation applies to.  anything issued outside of an
+ * operation, at startup or by event handlers, is accounted to TRACE_OP_NONE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fion.h"
+#include "log.h"
+#include "proto.h"
+
+struct account {
+	uint64_t	requests[256];
+	uint64_t	bytes;
+	uint64_t	roundtrips;
+	uint64_t	flushes;	/* its requests were written out by */
+	int		pending;	/* has requests not written out yet */
+};
+
+static struct account	accounts[TRACE_OP_COUNT + 1];
+static uint64_t		flushes;
+static uint32_t		iteration[256];	/* since account_iteration() */
+
+static const char *
+cause_name(int cause)
+{
+	if (cause == TRACE_OP_NONE)
+		return "other";
+	return trace_op_name(cause);
+}
+
+/*
+ * length is the size of the request in bytes, including its values.  the
+ * request is also traced with the resource it applies to and its sequence,
+ * 0 for requests sent by xcb-keysyms which keeps the cookie to itself.
+ */
+void
+account_request(int cause, uint8_t opcode, size_t length, uint32_t resource,
+    unsigned int sequence)
+{
+	accounts[cause].requests[opcode]++;
+	accounts[cause].bytes += length;
+	accounts[cause].pending = 1;
+	iteration[opcode]++;
+	TRACE(TRACE_REQUEST, opcode, resource, cause, sequence);
+}
+
+/* describe the requests issued since the last call and start over */
+void
+account_iteration(char *buf, size_t size)
+{
+	size_t	len = 0;
+	int	opcode;
+
+	buf[0] = '\0';
+	for (opcode = 0; opcode < 256; ++opcode) {
+		if (iteration[opcode] == 0)
+			continue;
+		if (len < size)
+			len += snprintf(buf + len, size - len, " %s=%u",
+			    proto_request_name(opcode), iteration[opcode]);
+		iteration[opcode] = 0;
+	}
+}
+
+/*
+ * also kept in wm->roundtrips for the startup report, waiting for a reply
+ * writes out the requests pending so it counts as a flush too.
+ */
+void
+account_roundtrip(struct wm *wm)
+{
+	accounts[trace_current].roundtrips++;
+	wm->roundtrips++;
+	account_flush(wm);
+}
+
+/* a flush is charged to every operation it wrote requests out for */
+void
+account_flush(struct wm *wm)
+{
+	int	cause;
+
+	flushes++;
+	for (cause = 0; cause <= TRACE_OP_NONE; ++cause) {
+		if (accounts[cause].pending) {
+			accounts[cause].flushes++;
+			accounts[cause].pending = 0;
+		}
+	}
+}
+
+void
+account_dump(struct wm *wm)
+{
+	const struct account   *account;
+	char			buf[1024];
+	uint64_t		requests, total;
+	size_t			len;
+	int			cause, opcode;
+
+	total = 0;
+	for (cause = 0; cause <= TRACE_OP_NONE; ++cause)
+		for (opcode = 0; opcode < 256; ++opcode)
+			total += accounts[cause].requests[opcode];
+
+	log_info("requests: %llu, %llu flushes, %llu bytes written, %llu read",
+	    (unsigned long long)total, (unsigned long long)flushes,
+	    (unsigned long long)xcb_total_written(wm->conn),
+	    (unsigned long long)xcb_total_read(wm->conn));
+
+	for (cause = 0; cause <= TRACE_OP_NONE; ++cause) {
+		account = &accounts[cause];
+
+		len = 0;
+		buf[0] = '\0';
+		requests = 0;
+		for (opcode = 0; opcode < 256; ++opcode) {
+			if (account->requests[opcode] == 0)
+				continue;
+			requests += account->requests[opcode];
+			if (len < sizeof buf)
+				len += snprintf(buf + len, sizeof buf - len, " %s=%llu",
+				    proto_request_name(opcode),
+				    (unsigned long long)account->requests[opcode]);
+		}
+		if (requests == 0 && account->roundtrips == 0)
+			continue;
+
+		log_info("%s: %llu requests, %llu bytes, %llu round trips, %llu flushes:%s",
+		    cause_name(cause), (unsigned long long)requests,
+		    (unsigned long long)account->bytes,
+		    (unsigned long long)account->roundtrips,
+		    (unsigned long long)account->flushes, buf);
+	}
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fion.h"
+#include "log.h"
+
+xcb_atom_t	atoms[ATOM_COUNT];
+
+static const char *atom_names[ATOM_COUNT] = {
+#define	X(name)	#name,
+	ATOMS(X)
+#undef	X
+};
+
+static xcb_intern_atom_cookie_t	cookies[ATOM_COUNT];
+static struct hash		names_by_atom;
+
+/*
+ * all atoms are requested at once, replies are collected by atom_collect()
+ * once some other startup reply had to be waited for anyway.
+ */
+void
+atom_intern(struct wm *wm)
+{
+	size_t i, len;
+
+	for (i = 0; i < ATOM_COUNT; ++i) {
+		len = strlen(atom_names[i]);
+		cookies[i] = xcb_intern_atom(wm->conn, 0, len, atom_names[i]);
+		account_request(trace_current, XCB_INTERN_ATOM,
+		    sizeof(xcb_intern_atom_request_t) + ((len + 3) & ~3), 0,
+		    cookies[i].sequence);
+	}
+}
+
+void
+atom_collect(struct wm *wm)
+{
+	xcb_intern_atom_reply_t *reply;
+	size_t i;
+
+	hash_init(&names_by_atom);
+	for (i = 0; i < ATOM_COUNT; ++i) {
+		reply = xcb_intern_atom_reply(wm->conn, cookies[i], NULL);
+		if (reply == NULL)
+			errx(1, "atom_collect: can't intern %s", atom_names[i]);
+		atoms[i] = reply->atom;
+		hash_set(&names_by_atom, atoms[i], &atom_names[i]);
+		free(reply);
+	}
+}
+
+const char *
+atom_name(xcb_atom_t atom)
+{
+	const char **name;
+
+	if ((name = hash_get(&names_by_atom, atom)) == NULL)
+		return NULL;
+	return *name;
+}
@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+# runs bench/e2e_bench against fion on a fresh Xvfb display for each
+# client count, fion is started with the tree's binary.
+
+FION=${FION:-./fion}
+COUNTS=${COUNTS:-"1 10 100 1000"}
+
+tmp=$(mktemp -d) || exit 1
+trap 'kill $fion $xvfb 2>/dev/null; rm -rf "$tmp"' EXIT
+
+for n in $COUNTS; do
+	# the server writes the display number it picked once it is ready
+	Xvfb -displayfd 3 -screen 0 1920x1080x24 -nolisten tcp \
+	    3>"$tmp/display" 2>"$tmp/xvfb.log" &
+	xvfb=$!
+	while [ ! -s "$tmp/display" ]; do
+		kill -0 $xvfb 2>/dev/null || { cat "$tmp/xvfb.log"; exit 1; }
+		sleep 0.1
+	done
+	export DISPLAY=:$(cat "$tmp/display")
+
+	$FION 2>"$tmp/fion.log" &
+	fion=$!
+
+	./bench/e2e_bench $n || { cat "$tmp/fion.log"; exit 1; }
+
+	kill $fion $xvfb
+	wait $fion $xvfb 2>/dev/null
+	: >"$tmp/display"
+done
@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * end-to-end latencies as seen by clients, run by bench/e2e.sh against fion
+ * on a virtual display:
+ *
+ * - map-to-placed: a window is mapped until its ConfigureNotify reports the
+ *   size of its tile, windows are mapped one after the other so that each
+ *   one is placed with all the previous ones already managed.
+ * - key-to-workspace-switch: Mod4-w n is typed through XTEST until the
+ *   workspace shown is unmapped.
+ * - key-to-split: Mod4-t h or v is typed until the windows of the split
+ *   tile are resized.
+ *
+ * the windows all belong to one connection, which fion cannot tell apart
+ * from as many clients and which does not hit the server's client limit.
+ */
+
+#include <err.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xcb/xcb.h>
+#include <xcb/xcb_keysyms.h>
+#include <xcb/xtest.h>
+#include <X11/keysym.h>
+
+#define	WINDOW_SIZE	17		/* never a tile size */
+#define	TIMEOUT		5000		/* ms, for a single step */
+#define	SWITCHES	100
+#define	SPLITS		16		/* tiles are halved, keep them visible */
+
+static xcb_connection_t	*conn;
+static xcb_screen_t	*screen;
+static xcb_key_symbols_t *ksyms;
+static xcb_window_t	*windows;
+static size_t		 nwindows;
+static int		 grabbed;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err(1, "clock_gettime");
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* keyboard grabs are followed through the focus events they generate */
+static void
+track_grab(xcb_generic_event_t *e)
+{
+	xcb_focus_in_event_t *ev = (xcb_focus_in_event_t *)e;
+
+	switch (e->response_type & ~0x80) {
+	case XCB_FOCUS_IN:
+	case XCB_FOCUS_OUT:
+		if (ev->mode == XCB_NOTIFY_MODE_GRAB)
+			grabbed = 1;
+		else if (ev->mode == XCB_NOTIFY_MODE_UNGRAB)
+			grabbed = 0;
+		break;
+	}
+}
+
+/* read events until match() accepts one, returns the time it arrived */
+static double
+wait_event(int (*match)(xcb_generic_event_t *, void *), void *arg)
+{
+	xcb_generic_event_t *e;
+	struct pollfd pfd;
+	double deadline, t;
+	int found;
+
+	pfd.fd = xcb_get_file_descriptor(conn);
+	pfd.events = POLLIN;
+	deadline = now() + TIMEOUT;
+	for (;;) {
+		while ((e = xcb_poll_for_event(conn)) != NULL) {
+			t = now();
+			track_grab(e);
+			found = match(e, arg);
+			free(e);
+			if (found)
+				return t;
+		}
+		if (xcb_connection_has_error(conn))
+			errx(1, "connection lost");
+		if ((t = now()) >= deadline)
+			errx(1, "timeout waiting for fion");
+		if (poll(&pfd, 1, deadline - t) == -1 && errno != EINTR)
+			err(1, "poll");
+	}
+}
+
+/* process everything the server has sent up to now */
+static void
+sync_events(void)
+{
+	xcb_generic_event_t *e;
+
+	free(xcb_get_input_focus_reply(conn, xcb_get_input_focus(conn), NULL));
+	while ((e = xcb_poll_for_event(conn)) != NULL) {
+		track_grab(e);
+		free(e);
+	}
+}
+
+static int
+match_grab(xcb_generic_event_t *e, void *arg)
+{
+	return grabbed;
+}
+
+static int
+match_placed(xcb_generic_event_t *e, void *arg)
+{
+	xcb_configure_notify_event_t *ev = (xcb_configure_notify_event_t *)e;
+	xcb_window_t *window = arg;
+
+	return (e->response_type & ~0x80) == XCB_CONFIGURE_NOTIFY &&
+	    ev->window == *window &&
+	    (ev->width != WINDOW_SIZE || ev->height != WINDOW_SIZE);
+}
+
+static int
+match_resized(xcb_generic_event_t *e, void *arg)
+{
+	xcb_configure_notify_event_t *ev = (xcb_configure_notify_event_t *)e;
+
+	return (e->response_type & ~0x80) == XCB_CONFIGURE_NOTIFY &&
+	    ev->event == ev->window;
+}
+
+static int
+match_unmap(xcb_generic_event_t *e, void *arg)
+{
+	xcb_unmap_notify_event_t *ev = (xcb_unmap_notify_event_t *)e;
+
+	return (e->response_type & ~0x80) == XCB_UNMAP_NOTIFY &&
+	    ev->event != ev->window;
+}
+
+static void
+fake_key(uint8_t type, xcb_keysym_t keysym)
+{
+	xcb_keycode_t *keycodes;
+
+	if ((keycodes = xcb_key_symbols_get_keycode(ksyms, keysym)) == NULL)
+		errx(1, "no keycode for keysym %#x", keysym);
+	xcb_test_fake_input(conn, type, keycodes[0], XCB_CURRENT_TIME,
+	    XCB_NONE, 0, 0, 0);
+	free(keycodes);
+}
+
+static void
+type_key(xcb_keysym_t keysym)
+{
+	fake_key(XCB_KEY_PRESS, keysym);
+	fake_key(XCB_KEY_RELEASE, keysym);
+}
+
+/*
+ * Mod4 then the mode key, returns once fion holds the keyboard grab so
+ * that the action key is not delivered to another window.
+ */
+static void
+type_prefix(xcb_keysym_t keysym)
+{
+	fake_key(XCB_KEY_PRESS, XK_Super_L);
+	type_key(keysym);
+	fake_key(XCB_KEY_RELEASE, XK_Super_L);
+	sync_events();
+	if (!grabbed)
+		wait_event(match_grab, NULL);
+}
+
+/* the action key, returns the time it was sent */
+static double
+type_action(xcb_keysym_t keysym)
+{
+	double t;
+
+	type_key(keysym);
+	t = now();
+	xcb_flush(conn);
+	return t;
+}
+
+/*
+ * fion is running once a client redirects the root's substructure, the
+ * root's attributes tell without racing fion for the redirection.
+ */
+static void
+wait_wm(void)
+{
+	xcb_get_window_attributes_reply_t *attr;
+	uint32_t value;
+	double deadline = now() + TIMEOUT;
+	struct timespec ts = { 0, 10 * 1000000 };
+	int managed;
+
+	for (;;) {
+		attr = xcb_get_window_attributes_reply(conn,
+		    xcb_get_window_attributes(conn, screen->root), NULL);
+		if (attr == NULL)
+			errx(1, "xcb_get_window_attributes");
+		managed = attr->all_event_masks &
+		    XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT;
+		free(attr);
+		if (managed)
+			break;
+		if (now() >= deadline)
+			errx(1, "fion is not running");
+		nanosleep(&ts, NULL);
+	}
+
+	value = XCB_EVENT_MASK_FOCUS_CHANGE;
+	xcb_change_window_attributes(conn, screen->root, XCB_CW_EVENT_MASK, &value);
+}
+
+/* workspaces are children of the work area, itself a child of the root */
+static void
+watch_workspaces(void)
+{
+	xcb_query_tree_reply_t *tree;
+	xcb_window_t *children;
+	uint32_t value = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+	size_t i, j;
+	int n;
+
+	tree = xcb_query_tree_reply(conn,
+	    xcb_query_tree(conn, screen->root), NULL);
+	if (tree == NULL)
+		errx(1, "xcb_query_tree");
+	n = xcb_query_tree_children_length(tree);
+	children = xcb_query_tree_children(tree);
+	for (i = 0; i < (size_t)n; ++i) {
+		for (j = 0; j < nwindows; ++j)
+			if (children[i] == windows[j])
+				break;
+		if (j == nwindows)
+			xcb_change_window_attributes(conn, children[i],
+			    XCB_CW_EVENT_MASK, &value);
+	}
+	free(tree);
+}
+
+static int
+cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void
+report(const char *name, double *samples, size_t n)
+{
+	qsort(samples, n, sizeof(*samples), cmp);
+	printf("N=%-5zu %-24s %4zu samples: p50 %8.3f ms  p99 %8.3f ms\n",
+	    nwindows, name, n, samples[(n - 1) / 2], samples[(n - 1) * 99 / 100]);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const xcb_query_extension_reply_t *xtest;
+	uint32_t mask = XCB_CW_EVENT_MASK;
+	uint32_t value = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+	double *samples, start;
+	size_t i;
+
+	if (argc != 2 || (nwindows = strtoul(argv[1], NULL, 10)) == 0)
+		errx(1, "usage: e2e_bench windows");
+
+	conn = xcb_connect(NULL, NULL);
+	if (xcb_connection_has_error(conn))
+		errx(1, "xcb_connect");
+	screen = xcb_setup_roots_iterator(xcb_get_setup(conn)).data;
+	xtest = xcb_get_extension_data(conn, &xcb_test_id);
+	if (xtest == NULL || !xtest->present)
+		errx(1, "the XTEST extension is not available");
+	if ((ksyms = xcb_key_symbols_alloc(conn)) == NULL)
+		errx(1, "xcb_key_symbols_alloc");
+
+	if ((windows = calloc(nwindows, sizeof(*windows))) == NULL ||
+	    (samples = calloc(nwindows + SWITCHES + SPLITS, sizeof(*samples))) == NULL)
+		err(1, "calloc");
+
+	wait_wm();
+
+	for (i = 0; i < nwindows; ++i) {
+		windows[i] = xcb_generate_id(conn);
+		xcb_create_window(conn, XCB_COPY_FROM_PARENT, windows[i],
+		    screen->root, 0, 0, WINDOW_SIZE, WINDOW_SIZE, 0,
+		    XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+		    mask, &value);
+	}
+	for (i = 0; i < nwindows; ++i) {
+		xcb_map_window(conn, windows[i]);
+		start = now();
+		xcb_flush(conn);
+		samples[i] = wait_event(match_placed, &windows[i]) - start;
+	}
+	report("map-to-placed", samples, nwindows);
+
+	/* a second workspace to switch to, the windows stay on the first */
+	watch_workspaces();
+	type_prefix(XK_w);
+	type_action(XK_c);
+	wait_event(match_unmap, NULL);
+	for (i = 0; i < SWITCHES; ++i) {
+		type_prefix(XK_w);
+		start = type_action(XK_n);
+		samples[i] = wait_event(match_unmap, NULL) - start;
+	}
+	report("key-to-workspace-switch", samples, SWITCHES);
+
+	/* the windows are on the first workspace */
+	if (SWITCHES % 2 == 0) {
+		type_prefix(XK_w);
+		type_action(XK_n);
+		wait_event(match_unmap, NULL);
+	}
+	for (i = 0; i < SPLITS; ++i) {
+		type_prefix(XK_t);
+		start = type_action(i % 2 ? XK_v : XK_h);
+		samples[i] = wait_event(match_resized, NULL) - start;
+	}
+	report("key-to-split", samples, SPLITS);
+
+	xcb_key_symbols_free(ksyms);
+	xcb_disconnect(conn);
+	free(samples);
+	free(windows);
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * compares the window registry backends on X resource id shaped keys:
+ * ids allocated by fion share a resource base, client ids come from
+ * other bases.
+ */
+
+#include <err.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hash.h"
+#include "tree.h"
+
+#define	LOOKUPS		1000000
+
+static uint64_t	*ids;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err(1, "clock_gettime");
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+bench_tree(size_t n)
+{
+	struct tree	t;
+	double		start, set, get, pop;
+	size_t		i;
+
+	tree_init(&t);
+
+	start = now();
+	for (i = 0; i < n; ++i)
+		tree_xset(&t, ids[i], &ids[i]);
+	set = now() - start;
+
+	start = now();
+	for (i = 0; i < LOOKUPS; ++i)
+		if (tree_get(&t, ids[random() % n]) == NULL)
+			errx(1, "tree_get");
+	get = now() - start;
+
+	start = now();
+	for (i = 0; i < n; ++i)
+		tree_xpop(&t, ids[i]);
+	pop = now() - start;
+
+	printf("tree  %6zu windows: set %6.1f ns  get %6.1f ns  pop %6.1f ns\n",
+	    n, set / n, get / LOOKUPS, pop / n);
+}
+
+static void
+bench_hash(size_t n)
+{
+	struct hash	h;
+	double		start, set, get, pop;
+	size_t		i;
+
+	hash_init(&h);
+
+	start = now();
+	for (i = 0; i < n; ++i)
+		hash_xset(&h, ids[i], &ids[i]);
+	set = now() - start;
+
+	start = now();
+	for (i = 0; i < LOOKUPS; ++i)
+		if (hash_get(&h, ids[random() % n]) == NULL)
+			errx(1, "hash_get");
+	get = now() - start;
+
+	start = now();
+	for (i = 0; i < n; ++i)
+		hash_xpop(&h, ids[i]);
+	pop = now() - start;
+
+	if (hash_count(&h) != 0)
+		errx(1, "hash_count");
+	hash_free(&h);
+
+	printf("hash  %6zu windows: set %6.1f ns  get %6.1f ns  pop %6.1f ns\n",
+	    n, set / n, get / LOOKUPS, pop / n);
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t	sizes[] = { 10, 100, 1000, 10000, 100000 };
+	size_t	i, j, n;
+
+	n = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+	if ((ids = calloc(n, sizeof(*ids))) == NULL)
+		err(1, "calloc");
+	for (i = 0; i < n; ++i)
+		ids[i] = ((uint64_t)(1 + i % 8) << 21) | (i / 8 + 1);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+		for (j = 0; j < 2; ++j) {
+			srandom(i);
+			if (j == 0)
+				bench_tree(sizes[i]);
+			else
+				bench_hash(sizes[i]);
+		}
+	}
+
+	free(ids);
+	return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * drives the layout library without a display: operations are applied to
+ * a fake screen and the render operations they produce are counted and
+ * dropped, so that the cost measured is the layout's alone.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "layout.h"
+
+#define	ROOT		1
+#define	OPERATIONS	10000	/* layout_update numbers workspaces by a walk */
+#define	BATCH		16	/* operations per commit, as in an event batch */
+
+static xcb_window_t	next_id = ROOT;
+static size_t		renders;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err(1, "clock_gettime");
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static xcb_window_t
+generate_id(struct wm *wm)
+{
+	return ++next_id;
+}
+
+static void
+commit(struct wm *wm)
+{
+	scene_commit(wm);
+	renders += wm->nops;
+	scene_clear(wm);
+}
+
+static void
+bench(struct wm *wm, const char *name, void (*op)(struct wm *, xcb_window_t),
+    size_t n)
+{
+	double	start, elapsed;
+	size_t	i;
+
+	renders = 0;
+	start = now();
+	for (i = 0; i < n; ++i) {
+		op(wm, ROOT);
+		if (i % BATCH == BATCH - 1)
+			commit(wm);
+	}
+	commit(wm);
+	elapsed = now() - start;
+
+	printf("%-26s %6zu ops: %8.1f ns/op  %5.2f renders/op\n",
+	    name, n, elapsed / n, (double)renders / n);
+}
+
+static void
+split_h(struct wm *wm, xcb_window_t root)
+{
+	layout_tile_split(wm, root, HSPLIT);
+}
+
+static void
+split_v(struct wm *wm, xcb_window_t root)
+{
+	layout_tile_split(wm, root, VSPLIT);
+}
+
+static void
+update(struct wm *wm, xcb_window_t root)
+{
+	layout_update(wm);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct wm	wm;
+	size_t		n = OPERATIONS;
+
+	if (argc > 1 && (n = strtoul(argv[1], NULL, 10)) == 0)
+		errx(1, "usage: layout_bench [operations]");
+
+	memset(&wm, 0, sizeof wm);
+	wm.generate_id = generate_id;
+	layout_init(&wm);
+	layout_screen_register(&wm, NULL, ROOT, 1920, 1080);
+	layout_screen_render(&wm);
+	commit(&wm);
+
+	/* tiles are split, walked and destroyed in the same proportions */
+	bench(&wm, "layout_tile_split (h)", split_h, n / 2);
+	bench(&wm, "layout_tile_split (v)", split_v, n / 2);
+	bench(&wm, "layout_tile_next", layout_tile_next, n);
+	bench(&wm, "layout_tile_prev", layout_tile_prev, n);
+	bench(&wm, "layout_tile_destroy", layout_tile_destroy, n);
+	bench(&wm, "layout_workspace_create", layout_workspace_create, n / 10);
+	bench(&wm, "layout_workspace_next", layout_workspace_next, n);
+	bench(&wm, "layout_update", update, n);
+
+	return 0;
+}
@@ -0,0 +1,623 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * client intake.
+ *
+ * every property needed to decide where a new client goes is requested as
+ * soon as the window is created, replies are only read when placement is
+ * decided so that clients created together have their requests overlap.
+ * clients usually set their properties between creating and mapping their
+ * window, changes are followed and the properties affected requested again.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fion.h"
+#include "log.h"
+
+#define	PROPERTY_LENGTH		256	/* in 32-bit units */
+
+static xcb_get_property_cookie_t intake_property(struct wm *, xcb_window_t, xcb_atom_t);
+static xcb_get_property_cookie_t *intake_cookie(struct intake *, xcb_atom_t);
+static xcb_get_property_reply_t *intake_reply(struct wm *, xcb_get_property_cookie_t *);
+static char *intake_string(xcb_get_property_reply_t *);
+static void intake_discard(struct wm *, struct intake *);
+static void client_save(struct wm *, xcb_window_t);
+static void client_float(struct wm *, xcb_window_t);
+
+/* intake requests are accounted to the placement they are issued for */
+static xcb_get_property_cookie_t
+intake_property(struct wm *wm, xcb_window_t window, xcb_atom_t property)
+{
+	xcb_get_property_cookie_t cookie;
+
+	cookie = xcb_get_property(wm->conn, 0, window, property,
+	    XCB_GET_PROPERTY_TYPE_ANY, 0, PROPERTY_LENGTH);
+	account_request(TRACE_OP_CLIENT_INTAKE, XCB_GET_PROPERTY,
+	    sizeof(xcb_get_property_request_t), window, cookie.sequence);
+	return cookie;
+}
+
+/* the cookie a property is read through, NULL for those we do not read */
+static xcb_get_property_cookie_t *
+intake_cookie(struct intake *intake, xcb_atom_t property)
+{
+	if (property == atoms[ATOM_WM_CLASS])
+		return &intake->cookie_class;
+	if (property == atoms[ATOM_WM_NAME])
+		return &intake->cookie_name;
+	if (property == atoms[ATOM__NET_WM_NAME])
+		return &intake->cookie_net_name;
+	if (property == atoms[ATOM_WM_HINTS])
+		return &intake->cookie_hints;
+	if (property == atoms[ATOM_WM_NORMAL_HINTS])
+		return &intake->cookie_normal_hints;
+	if (property == atoms[ATOM_WM_TRANSIENT_FOR])
+		return &intake->cookie_transient_for;
+	if (property == atoms[ATOM_WM_PROTOCOLS])
+		return &intake->cookie_protocols;
+	if (property == atoms[ATOM__NET_WM_WINDOW_TYPE])
+		return &intake->cookie_type;
+	return NULL;
+}
+
+static xcb_get_property_reply_t *
+intake_reply(struct wm *wm, xcb_get_property_cookie_t *cookie)
+{
+	xcb_get_property_reply_t *reply;
+
+	reply = fion_reply(wm, cookie->sequence);
+	cookie->sequence = 0;
+	if (reply && reply->type == XCB_NONE) {
+		free(reply);
+		return NULL;
+	}
+	return reply;
+}
+
+static char *
+intake_string(xcb_get_property_reply_t *reply)
+{
+	char *s;
+
+	if (reply == NULL)
+		return NULL;
+	s = strndup(xcb_get_property_value(reply),
+	    xcb_get_property_value_length(reply));
+	if (s == NULL)
+		err(1, "intake_string: strndup");
+	return s;
+}
+
+struct intake *
+client_intake(struct wm *wm, xcb_window_t xcb_root, xcb_window_t xcb_window)
+{
+	struct intake *intake;
+	xcb_void_cookie_t cookie;
+	uint32_t value = XCB_EVENT_MASK_PROPERTY_CHANGE;
+
+	if ((intake = calloc(1, sizeof(*intake))) == NULL)
+		err(1, "client_intake: calloc");
+
+	intake->xcb_root = xcb_root;
+	intake->xcb_window = xcb_window;
+
+	/* selected first, replies below reflect any change made before it */
+	cookie = xcb_change_window_attributes_checked(wm->conn, xcb_window,
+	    XCB_CW_EVENT_MASK, &value);
+	xcb_discard_reply(wm->conn, cookie.sequence);
+	account_request(TRACE_OP_CLIENT_INTAKE, XCB_CHANGE_WINDOW_ATTRIBUTES,
+	    sizeof(xcb_change_window_attributes_request_t) + 4, xcb_window,
+	    cookie.sequence);
+
+	intake->cookie_attr = xcb_get_window_attributes(wm->conn, xcb_window);
+	account_request(TRACE_OP_CLIENT_INTAKE, XCB_GET_WINDOW_ATTRIBUTES,
+	    sizeof(xcb_get_window_attributes_request_t), xcb_window,
+	    intake->cookie_attr.sequence);
+	intake->cookie_class = intake_property(wm, xcb_window, atoms[ATOM_WM_CLASS]);
+	intake->cookie_name = intake_property(wm, xcb_window, atoms[ATOM_WM_NAME]);
+	intake->cookie_net_name = intake_property(wm, xcb_window, atoms[ATOM__NET_WM_NAME]);
+	intake->cookie_hints = intake_property(wm, xcb_window, atoms[ATOM_WM_HINTS]);
+	intake->cookie_normal_hints = intake_property(wm, xcb_window, atoms[ATOM_WM_NORMAL_HINTS]);
+	intake->cookie_transient_for = intake_property(wm, xcb_window, atoms[ATOM_WM_TRANSIENT_FOR]);
+	intake->cookie_protocols = intake_property(wm, xcb_window, atoms[ATOM_WM_PROTOCOLS]);
+	intake->cookie_type = intake_property(wm, xcb_window, atoms[ATOM__NET_WM_WINDOW_TYPE]);
+
+	hash_xset(&wm->intakes, xcb_window, intake);
+	return intake;
+}
+
+/* the client asked to be mapped, place it at the end of the batch */
+void
+client_intake_queue(struct wm *wm, struct intake *intake)
+{
+	if (intake->queued)
+		return;
+	TAILQ_INSERT_TAIL(&wm->intake_queue, intake, entry);
+	intake->queued = 1;
+}
+
+struct intake *
+client_intake_get(struct wm *wm, xcb_window_t xcb_window)
+{
+	return hash_get(&wm->intakes, xcb_window);
+}
+
+/*
+ * a property of a window not tiled yet changed, request it again so that
+ * the next placement sees its current value.  tiled clients are never
+ * classified again, their changes are not followed.
+ */
+void
+client_intake_property(struct wm *wm, xcb_property_notify_event_t *ev)
+{
+	struct intake *intake;
+	xcb_get_property_cookie_t *cookie;
+
+	if ((intake = client_intake_get(wm, ev->window)) == NULL ||
+	    layout_window_exists(wm, ev->window))
+		return;
+	if ((cookie = intake_cookie(intake, ev->atom)) == NULL)
+		return;
+
+	if (cookie->sequence)
+		xcb_discard_reply(wm->conn, cookie->sequence);
+	*cookie = intake_property(wm, ev->window, ev->atom);
+}
+
+/* read the replies pending for an intake, properties left unchanged are kept */
+void
+client_intake_resolve(struct wm *wm, struct intake *intake)
+{
+	xcb_get_window_attributes_reply_t *attr;
+	xcb_get_property_reply_t *reply;
+	xcb_atom_t *atom;
+	const char *type;
+	size_t len, n;
+
+	if (intake->cookie_attr.sequence) {
+		attr = fion_reply(wm, intake->cookie_attr.sequence);
+		intake->cookie_attr.sequence = 0;
+		if (attr == NULL) {
+			/* window is already gone */
+			intake->gone = 1;
+		} else {
+			intake->override_redirect = attr->override_redirect;
+			intake->input_only = attr->_class == XCB_WINDOW_CLASS_INPUT_ONLY;
+			intake->viewable = attr->map_state == XCB_MAP_STATE_VIEWABLE;
+			free(attr);
+		}
+	}
+
+	if (intake->cookie_class.sequence) {
+		free(intake->instance);
+		free(intake->class);
+		intake->instance = intake->class = NULL;
+		if ((reply = intake_reply(wm, &intake->cookie_class)) != NULL) {
+			/* instance and class, both nul terminated */
+			len = xcb_get_property_value_length(reply);
+			intake->instance = intake_string(reply);
+			n = strlen(intake->instance) + 1;
+			if (n < len && (intake->class = strndup((char *)xcb_get_property_value(reply) + n, len - n)) == NULL)
+				err(1, "client_intake_resolve: strndup");
+			free(reply);
+		}
+	}
+
+	if (intake->cookie_net_name.sequence) {
+		free(intake->net_name);
+		intake->net_name = NULL;
+		if ((reply = intake_reply(wm, &intake->cookie_net_name)) != NULL) {
+			intake->net_name = intake_string(reply);
+			free(reply);
+		}
+	}
+	if (intake->cookie_name.sequence) {
+		free(intake->name);
+		intake->name = NULL;
+		if ((reply = intake_reply(wm, &intake->cookie_name)) != NULL) {
+			intake->name = intake_string(reply);
+			free(reply);
+		}
+	}
+
+	if (intake->cookie_hints.sequence) {
+		intake->has_hints = 0;
+		if ((reply = intake_reply(wm, &intake->cookie_hints)) != NULL) {
+			intake->has_hints = xcb_icccm_get_wm_hints_from_reply(&intake->hints, reply);
+			free(reply);
+		}
+	}
+
+	if (intake->cookie_normal_hints.sequence) {
+		intake->has_normal_hints = 0;
+		if ((reply = intake_reply(wm, &intake->cookie_normal_hints)) != NULL) {
+			intake->has_normal_hints =
+			    xcb_icccm_get_wm_size_hints_from_reply(&intake->normal_hints, reply);
+			free(reply);
+		}
+	}
+
+	if (intake->cookie_transient_for.sequence) {
+		intake->transient_for = XCB_NONE;
+		if ((reply = intake_reply(wm, &intake->cookie_transient_for)) != NULL) {
+			if (! xcb_icccm_get_wm_transient_for_from_reply(&intake->transient_for, reply))
+				intake->transient_for = XCB_NONE;
+			free(reply);
+		}
+	}
+
+	if (intake->cookie_protocols.sequence) {
+		intake->delete_window = 0;
+		intake->take_focus = 0;
+		if ((reply = intake_reply(wm, &intake->cookie_protocols)) != NULL) {
+			if (reply->format == 32) {
+				atom = xcb_get_property_value(reply);
+				len = xcb_get_property_value_length(reply) / sizeof(*atom);
+				for (n = 0; n < len; ++n) {
+					if (atom[n] == atoms[ATOM_WM_DELETE_WINDOW])
+						intake->delete_window = 1;
+					else if (atom[n] == atoms[ATOM_WM_TAKE_FOCUS])
+						intake->take_focus = 1;
+				}
+			}
+			free(reply);
+		}
+	}
+
+	if (intake->cookie_type.sequence) {
+		intake->type = XCB_NONE;
+		if ((reply = intake_reply(wm, &intake->cookie_type)) != NULL) {
+			if (reply->format == 32 && xcb_get_property_value_length(reply) >= 4)
+				intake->type = *(xcb_atom_t *)xcb_get_property_value(reply);
+			free(reply);
+		}
+	}
+
+	type = intake->type ? atom_name(intake->type) : "-";
+	log_debug("client_intake: %u class=%s instance=%s name=%s type=%s transient_for=%u",
+	    intake->xcb_window,
+	    intake->class ? intake->class : "-",
+	    intake->instance ? intake->instance : "-",
+	    intake->net_name ? intake->net_name :
+	    intake->name ? intake->name : "-",
+	    type ? type : "<unknown>",
+	    intake->transient_for);
+}
+/*
+ * only plain top-level windows are tiled, dialogs and other transient
+ * windows float where they asked to be and never cause a reflow.
+ */
+enum intake_class
+client_intake_classify(struct intake *intake)
+{
+	static const enum atom floating[] = {
+		ATOM__NET_WM_WINDOW_TYPE_DIALOG,
+		ATOM__NET_WM_WINDOW_TYPE_UTILITY,
+		ATOM__NET_WM_WINDOW_TYPE_SPLASH,
+		ATOM__NET_WM_WINDOW_TYPE_DOCK,
+		ATOM__NET_WM_WINDOW_TYPE_MENU,
+		ATOM__NET_WM_WINDOW_TYPE_DROPDOWN_MENU,
+		ATOM__NET_WM_WINDOW_TYPE_POPUP_MENU,
+		ATOM__NET_WM_WINDOW_TYPE_TOOLTIP,
+		ATOM__NET_WM_WINDOW_TYPE_NOTIFICATION,
+	};
+	size_t i;
+
+	if (intake->gone)
+		return INTAKE_GONE;
+	if (intake->override_redirect || intake->input_only)
+		return INTAKE_IGNORE;
+	if (intake->transient_for != XCB_NONE)
+		return INTAKE_FLOAT;
+	for (i = 0; i < sizeof(floating) / sizeof(floating[0]); ++i)
+		if (intake->type == atoms[floating[i]])
+			return INTAKE_FLOAT;
+	return INTAKE_MANAGE;
+}
+
+/* drop replies that were never read */
+static void
+intake_discard(struct wm *wm, struct intake *intake)
+{
+	xcb_get_property_cookie_t *cookies[] = {
+		&intake->cookie_class, &intake->cookie_name,
+		&intake->cookie_net_name, &intake->cookie_hints,
+		&intake->cookie_normal_hints, &intake->cookie_transient_for,
+		&intake->cookie_protocols, &intake->cookie_type,
+	};
+	size_t i;
+
+	if (intake->cookie_attr.sequence)
+		xcb_discard_reply(wm->conn, intake->cookie_attr.sequence);
+	for (i = 0; i < sizeof(cookies) / sizeof(cookies[0]); ++i)
+		if (cookies[i]->sequence)
+			xcb_discard_reply(wm->conn, cookies[i]->sequence);
+}
+
+/* the intake is no longer pending placement, it remains attached to its window */
+void
+client_intake_done(struct wm *wm, struct intake *intake)
+{
+	if (intake->queued) {
+		TAILQ_REMOVE(&wm->intake_queue, intake, entry);
+		intake->queued = 0;
+	}
+}
+
+void
+client_intake_free(struct wm *wm, struct intake *intake)
+{
+	if (intake == NULL)
+		return;
+
+	client_intake_done(wm, intake);
+	hash_pop(&wm->intakes, intake->xcb_window);
+	intake_discard(wm, intake);
+
+	free(intake->instance);
+	free(intake->class);
+	free(intake->name);
+	free(intake->net_name);
+	free(intake);
+}
+
+/*
+ * clients are reparented into our windows, keep them in the save-set so
+ * that they survive us and can be adopted again by the next instance.
+ */
+static void
+client_save(struct wm *wm, xcb_window_t xcb_window)
+{
+	xcb_void_cookie_t cookie;
+
+	cookie = xcb_change_save_set(wm->conn, XCB_SET_MODE_INSERT, xcb_window);
+	account_request(trace_current, XCB_CHANGE_SAVE_SET,
+	    sizeof(xcb_change_save_set_request_t), xcb_window, cookie.sequence);
+}
+
+/* floating clients are left where they asked to be, above the layout */
+static void
+client_float(struct wm *wm, xcb_window_t xcb_window)
+{
+	xcb_void_cookie_t cookie;
+	uint32_t value = XCB_STACK_MODE_ABOVE;
+
+	cookie = xcb_configure_window(wm->conn, xcb_window,
+	    XCB_CONFIG_WINDOW_STACK_MODE, &value);
+	account_request(trace_current, XCB_CONFIGURE_WINDOW,
+	    sizeof(xcb_configure_window_request_t) + 4, xcb_window,
+	    cookie.sequence);
+	cookie = xcb_map_window(wm->conn, xcb_window);
+	account_request(trace_current, XCB_MAP_WINDOW,
+	    sizeof(xcb_map_window_request_t), xcb_window, cookie.sequence);
+}
+
+/*
+ * take over the windows that existed before we started.  requests are sent
+ * in two waves, the window list of every screen then the intake and state
+ * of every window, so that the scan costs two round trips whatever the
+ * window count.  windows are then classified as if they had just been mapped.
+ */
+void
+client_adopt(struct wm *wm)
+{
+	struct adopt {
+		struct intake			*intake;
+		xcb_get_geometry_cookie_t	 geometry;
+		xcb_get_property_cookie_t	 state;
+	} *adopt;
+	xcb_query_tree_cookie_t *tree_cookies;
+	xcb_query_tree_reply_t *tree_reply;
+	xcb_get_geometry_reply_t *geometry;
+	xcb_get_property_reply_t *state;
+	xcb_window_t *children;
+	struct window **screens;
+	struct window *client;
+	struct intake *intake;
+	size_t nscreens, nadopt, i;
+	uint32_t wmstate;
+	void *iter;
+	int j, n;
+
+	nscreens = tree_count(&wm->screens_by_window);
+	if ((screens = calloc(nscreens, sizeof(*screens))) == NULL ||
+	    (tree_cookies = calloc(nscreens, sizeof(*tree_cookies))) == NULL)
+		err(1, "client_adopt: calloc");
+
+	i = 0;
+	iter = NULL;
+	while (tree_iter(&wm->screens_by_window, &iter, NULL, (void **)&screens[i])) {
+		tree_cookies[i] = xcb_query_tree(wm->conn, screens[i]->xcb_screen->root);
+		account_request(trace_current, XCB_QUERY_TREE,
+		    sizeof(xcb_query_tree_request_t),
+		    screens[i]->xcb_screen->root, tree_cookies[i].sequence);
+		i++;
+	}
+
+	adopt = NULL;
+	nadopt = 0;
+	for (i = 0; i < nscreens; ++i) {
+		tree_reply = fion_reply(wm, tree_cookies[i].sequence);
+		if (tree_reply == NULL)
+			continue;
+
+		n = xcb_query_tree_children_length(tree_reply);
+		children = xcb_query_tree_children(tree_reply);
+		if (n == 0) {
+			free(tree_reply);
+			continue;
+		}
+		if ((adopt = reallocarray(adopt, nadopt + n, sizeof(*adopt))) == NULL)
+			err(1, "client_adopt: reallocarray");
+
+		for (j = 0; j < n; ++j) {
+			/* our own windows are children of the root too */
+			if (layout_window_exists(wm, children[j]))
+				continue;
+			adopt[nadopt].intake = client_intake(wm,
+			    screens[i]->xcb_screen->root, children[j]);
+			adopt[nadopt].geometry = xcb_get_geometry(wm->conn, children[j]);
+			adopt[nadopt].state = xcb_get_property(wm->conn, 0, children[j],
+			    atoms[ATOM_WM_STATE], atoms[ATOM_WM_STATE], 0, 2);
+			account_request(trace_current, XCB_GET_GEOMETRY,
+			    sizeof(xcb_get_geometry_request_t), children[j],
+			    adopt[nadopt].geometry.sequence);
+			account_request(trace_current, XCB_GET_PROPERTY,
+			    sizeof(xcb_get_property_request_t), children[j],
+			    adopt[nadopt].state.sequence);
+			nadopt++;
+		}
+		free(tree_reply);
+	}
+
+	for (i = 0; i < nadopt; ++i) {
+		intake = adopt[i].intake;
+		client_intake_resolve(wm, intake);
+		geometry = fion_reply(wm, adopt[i].geometry.sequence);
+		state = fion_reply(wm, adopt[i].state.sequence);
+
+		wmstate = XCB_ICCCM_WM_STATE_WITHDRAWN;
+		if (state && xcb_get_property_value_length(state) >= 4)
+			wmstate = *(uint32_t *)xcb_get_property_value(state);
+
+		if (geometry == NULL || intake->gone || intake->override_redirect) {
+			/* gone, or never followed as in on_create_notify() */
+			client_intake_free(wm, intake);
+		}
+		/* top-level windows that are viewable, or iconic as per WM_STATE */
+		else if (intake->viewable || wmstate == XCB_ICCCM_WM_STATE_ICONIC) {
+			switch (client_intake_classify(intake)) {
+			case INTAKE_MANAGE:
+				log_debug("adopting window %u (%dx%d)", intake->xcb_window,
+				    geometry->width, geometry->height);
+				client = layout_client_create(wm, intake->xcb_root, intake->xcb_window);
+				client_save(wm, intake->xcb_window);
+				client->intake = intake;
+				client->sent.width = geometry->width;
+				client->sent.height = geometry->height;
+				client->sent.mapped = intake->viewable;
+				scene_map(wm, client);
+				break;
+
+			case INTAKE_FLOAT:
+				log_debug("adopting floating window %u", intake->xcb_window);
+				client_float(wm, intake->xcb_window);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		free(geometry);
+		free(state);
+	}
+
+	free(adopt);
+	free(tree_cookies);
+	free(screens);
+}
+
+/*
+ * place the clients that asked to be mapped during the last batch of events,
+ * intakes remain for as long as their window exists so that mapping it again
+ * does not request its properties again.
+ */
+void
+client_place(struct wm *wm)
+{
+	xcb_void_cookie_t cookie;
+	struct intake *intake;
+	struct window *client;
+
+	while ((intake = TAILQ_FIRST(&wm->intake_queue)) != NULL) {
+		client_intake_done(wm, intake);
+		client_intake_resolve(wm, intake);
+
+		switch (client_intake_classify(intake)) {
+		case INTAKE_GONE:
+			client_intake_free(wm, intake);
+			break;
+
+		case INTAKE_IGNORE:
+			cookie = xcb_map_window(wm->conn, intake->xcb_window);
+			account_request(trace_current, XCB_MAP_WINDOW,
+			    sizeof(xcb_map_window_request_t), intake->xcb_window,
+			    cookie.sequence);
+			break;
+
+		case INTAKE_FLOAT:
+			client_float(wm, intake->xcb_window);
+			break;
+
+		case INTAKE_MANAGE:
+			client = layout_client_create(wm, intake->xcb_root, intake->xcb_window);
+			client_save(wm, intake->xcb_window);
+			client->intake = intake;
+			scene_map(wm, client);
+			break;
+		}
+	}
+}
+
+/* tiled clients get their tile, whatever they asked for */
+void
+client_configure(struct wm *wm, xcb_configure_request_event_t *ev)
+{
+	struct window *client = layout_window_get(wm, ev->window);
+	xcb_void_cookie_t cookie;
+	uint32_t values[7];
+	int n = 0;
+
+	if (client && client->type == WT_CLIENT) {
+		window_configure_notify(wm, client);
+		return;
+	}
+
+	/* not placed by us, grant the request as is */
+	if (ev->value_mask & XCB_CONFIG_WINDOW_X)
+		values[n++] = ev->x;
+	if (ev->value_mask & XCB_CONFIG_WINDOW_Y)
+		values[n++] = ev->y;
+	if (ev->value_mask & XCB_CONFIG_WINDOW_WIDTH)
+		values[n++] = ev->width;
+	if (ev->value_mask & XCB_CONFIG_WINDOW_HEIGHT)
+		values[n++] = ev->height;
+	if (ev->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+		values[n++] = ev->border_width;
+	if (ev->value_mask & XCB_CONFIG_WINDOW_SIBLING)
+		values[n++] = ev->sibling;
+	if (ev->value_mask & XCB_CONFIG_WINDOW_STACK_MODE)
+		values[n++] = ev->stack_mode;
+	cookie = xcb_configure_window(wm->conn, ev->window, ev->value_mask,
+	    values);
+	account_request(trace_current, XCB_CONFIGURE_WINDOW,
+	    sizeof(xcb_configure_window_request_t) + n * 4, ev->window,
+	    cookie.sequence);
+}
+
+/* forget about a client, whether it was placed yet or not */
+void
+client_destroy(struct wm *wm, xcb_window_t xcb_window)
+{
+	client_intake_free(wm, client_intake_get(wm, xcb_window));
+	layout_client_destroy(wm, xcb_window);
+}
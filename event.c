@@ -14,11 +14,16 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <sys/signalfd.h>
+
 #include <err.h>
+#include <errno.h>
 #include <poll.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "fion.h"
@@ -29,13 +34,29 @@
 #define	KBMODE_TILE		2
 #define	KBMODE_RUN		3
 
+#define	KBMODE_TIMEOUT		2000	/* ms */
+
+
+struct expect_error {
+	const char	       *op;
+	error_cb		cb;
+	void		       *arg;
+};
 
 static int		running = 1;
 static int		mode;
+static uint64_t		flushes;
+static time_t		flushes_since;
+static struct timespec	mode_deadline;
+
+static void	mode_enter(struct wm *wm, xcb_window_t screen, int kbmode);
+static void	mode_leave(struct wm *wm);
+static int	mode_remaining(void);
+
 static inline void	event_quit(struct wm *wm, xcb_window_t screen) { running = 0; }
-static inline void	event_workspace(struct wm *wm, xcb_window_t screen) { mode = KBMODE_WORKSPACE; log_debug("workspace mode"); }
-static inline void	event_tile(struct wm *wm, xcb_window_t screen) { mode = KBMODE_TILE; log_debug("tile mode"); }
-static inline void	event_run(struct wm *wm, xcb_window_t screen) { mode = KBMODE_RUN; log_debug("run mode"); }
+static inline void	event_workspace(struct wm *wm, xcb_window_t screen) { mode_enter(wm, screen, KBMODE_WORKSPACE); log_debug("workspace mode"); }
+static inline void	event_tile(struct wm *wm, xcb_window_t screen) { mode_enter(wm, screen, KBMODE_TILE); log_debug("tile mode"); }
+static inline void	event_run(struct wm *wm, xcb_window_t screen) { mode_enter(wm, screen, KBMODE_RUN); log_debug("run mode"); }
 
 static inline void
 kb_c(struct wm *wm, xcb_window_t screen)
@@ -45,7 +66,7 @@ kb_c(struct wm *wm, xcb_window_t screen)
 		wm_workspace_create(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
 static inline void
@@ -59,7 +80,7 @@ kb_d(struct wm *wm, xcb_window_t screen)
 		wm_tile_destroy(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
 static inline void
@@ -73,7 +94,7 @@ kb_n(struct wm *wm, xcb_window_t screen)
 		wm_tile_next(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
 static inline void
@@ -87,7 +108,7 @@ kb_p(struct wm *wm, xcb_window_t screen)
 		wm_tile_prev(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
 static inline void
@@ -98,7 +119,7 @@ kb_h(struct wm *wm, xcb_window_t screen)
 		wm_tile_split_h(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
 static inline void
@@ -109,7 +130,7 @@ kb_v(struct wm *wm, xcb_window_t screen)
 		wm_tile_split_v(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
 static inline void
@@ -120,9 +141,16 @@ kb_t(struct wm *wm, xcb_window_t screen)
 		wm_run_terminal(wm, screen);
 		break;
 	}
-	mode = 0;
+	mode_leave(wm);
 }
 
+/* modifier states distinguished by the keymap */
+static uint16_t		keymap_mods[] = { 0, XCB_MOD_MASK_4 };
+#define	KEYMAP_MODS	(sizeof(keymap_mods) / sizeof(keymap_mods[0]))
+
+static xcb_key_symbols_t *ksyms;
+static struct key	*keymap[256][KEYMAP_MODS];
+
 static struct key	keys[] = {
 	{ XCB_MOD_MASK_4,	XK_q,		event_quit },
 
@@ -141,6 +169,13 @@ static struct key	keys[] = {
 	{ 0,	XK_t,		kb_t },		/* terminal */
 };
 
+static void	keymap_build(struct wm *wm, xcb_keycode_t first, int count);
+static int	keymap_modidx(uint16_t state);
+
+static void	event_prune_errors(struct wm *wm, uint32_t sequence);
+
+static void	event_signals(struct wm *wm);
+static void	on_error(struct wm *wm, xcb_generic_error_t *ev);
 static void	on_key_press(struct wm *wm, xcb_key_press_event_t *ev);
 static void	on_key_release(struct wm *wm, xcb_key_release_event_t *ev);
 static void	on_button_press(struct wm *wm, xcb_button_press_event_t *ev);
@@ -176,29 +211,199 @@ static void	on_client_message(struct wm *wm, xcb_client_message_event_t *ev);
 static void	on_mapping_notify(struct wm *wm, xcb_mapping_notify_event_t *ev);
 static void	on_ge_generic(struct wm *wm, xcb_ge_generic_event_t *ev);
 
+void
+event_init(struct wm *wm)
+{
+	const xcb_setup_t *setup = xcb_get_setup(wm->conn);
+
+	if ((ksyms = xcb_key_symbols_alloc(wm->conn)) == NULL)
+		errx(1, "xcb_key_symbols_alloc");
+	account_request(trace_current, XCB_GET_KEYBOARD_MAPPING,
+	    sizeof(xcb_get_keyboard_mapping_request_t), 0, 0);
+
+	/* the first lookup waits for the keyboard mapping */
+	account_roundtrip(wm);
+	keymap_build(wm, setup->min_keycode,
+	    setup->max_keycode - setup->min_keycode + 1);
+}
+
+/*
+ * only modifier prefixes are grabbed passively, the key following a prefix
+ * is read through an active keyboard grab held for the duration of the mode.
+ */
 void
 event_grab_keys(struct wm *wm, struct window *screen)
 {
-	int i;
-	int j;
-	xcb_key_symbols_t *ksyms;
-	xcb_keycode_t *kcode;
-
-	ksyms = xcb_key_symbols_alloc(wm->conn);
-	for (i = 0; (unsigned long)i < sizeof(keys) / sizeof(struct key); ++i) {
-		kcode = xcb_key_symbols_get_keycode(ksyms, keys[i].ksym);
-		for (j = 0; kcode[j] != XCB_NO_SYMBOL; ++j)
-			xcb_grab_key(wm->conn, 1, screen->xcb_window,
-			    keys[j].mod, kcode[j],
-			    XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-		free(kcode);
+	xcb_void_cookie_t cookie;
+	size_t i;
+	int kc;
+
+	cookie = xcb_ungrab_key(wm->conn, XCB_GRAB_ANY, screen->xcb_window,
+	    XCB_MOD_MASK_ANY);
+	account_request(trace_current, XCB_UNGRAB_KEY,
+	    sizeof(xcb_ungrab_key_request_t), screen->xcb_window,
+	    cookie.sequence);
+	for (kc = 0; kc < 256; ++kc)
+		for (i = 0; i < KEYMAP_MODS; ++i)
+			if (keymap[kc][i] && keymap[kc][i]->mod) {
+				cookie = xcb_grab_key(wm->conn, 1,
+				    screen->xcb_window, keymap[kc][i]->mod, kc,
+				    XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+				account_request(trace_current, XCB_GRAB_KEY,
+				    sizeof(xcb_grab_key_request_t),
+				    screen->xcb_window, cookie.sequence);
+			}
+}
+
+/*
+ * resolve keys[] into a table indexed by keycode and modifier state so that
+ * a key press is a single lookup, only the given keycode range is rebuilt.
+ */
+static void
+keymap_build(struct wm *wm, xcb_keycode_t first, int count)
+{
+	xcb_keysym_t ksym;
+	size_t i, j;
+	int kc;
+
+	for (kc = first; kc < first + count && kc < 256; ++kc) {
+		for (j = 0; j < KEYMAP_MODS; ++j)
+			keymap[kc][j] = NULL;
+
+		ksym = xcb_key_symbols_get_keysym(ksyms, kc, 0);
+		if (ksym == XCB_NO_SYMBOL)
+			continue;
+
+		for (i = 0; i < sizeof(keys) / sizeof(struct key); ++i) {
+			if (keys[i].ksym != ksym || keys[i].cb == NULL)
+				continue;
+			for (j = 0; j < KEYMAP_MODS; ++j)
+				if (keymap[kc][j] == NULL &&
+				    (keys[i].mod == 0 || (keymap_mods[j] & keys[i].mod)))
+					keymap[kc][j] = &keys[i];
+		}
+	}
+}
+
+static void
+mode_enter(struct wm *wm, xcb_window_t screen, int kbmode)
+{
+	xcb_grab_keyboard_cookie_t cookie;
+
+	if (mode == 0) {
+		cookie = xcb_grab_keyboard(wm->conn, 0, screen,
+		    XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+		xcb_discard_reply(wm->conn, cookie.sequence);
+		account_request(trace_current, XCB_GRAB_KEYBOARD,
+		    sizeof(xcb_grab_keyboard_request_t), screen,
+		    cookie.sequence);
+	}
+	mode = kbmode;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &mode_deadline) == -1)
+		err(1, "clock_gettime");
+	mode_deadline.tv_sec += KBMODE_TIMEOUT / 1000;
+	mode_deadline.tv_nsec += (KBMODE_TIMEOUT % 1000) * 1000000;
+	if (mode_deadline.tv_nsec >= 1000000000) {
+		mode_deadline.tv_sec++;
+		mode_deadline.tv_nsec -= 1000000000;
+	}
+}
+
+static void
+mode_leave(struct wm *wm)
+{
+	xcb_void_cookie_t cookie;
+
+	if (mode) {
+		cookie = xcb_ungrab_keyboard(wm->conn, XCB_CURRENT_TIME);
+		account_request(trace_current, XCB_UNGRAB_KEYBOARD,
+		    sizeof(xcb_ungrab_keyboard_request_t), 0, cookie.sequence);
+	}
+	mode = 0;
+}
+
+/* milliseconds left before the current mode expires */
+static int
+mode_remaining(void)
+{
+	struct timespec ts;
+	long long ms;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err(1, "clock_gettime");
+	ms = (long long)(mode_deadline.tv_sec - ts.tv_sec) * 1000 +
+	    (mode_deadline.tv_nsec - ts.tv_nsec) / 1000000;
+	return ms < 0 ? 0 : ms;
+}
+
+static int
+keymap_modidx(uint16_t state)
+{
+	size_t i;
+
+	for (i = KEYMAP_MODS - 1; i > 0; --i)
+		if (state & keymap_mods[i])
+			return i;
+	return 0;
+}
+
+/*
+ * requests are sent unchecked, an operation interested in the failure of
+ * one of its requests registers a callback for its sequence number.
+ */
+void
+event_expect_error(struct wm *wm, xcb_void_cookie_t cookie, const char *op,
+    error_cb cb, void *arg)
+{
+	struct expect_error *expect;
+
+	if ((expect = calloc(1, sizeof(*expect))) == NULL)
+		err(1, "event_expect_error: calloc");
+	expect->op = op;
+	expect->cb = cb;
+	expect->arg = arg;
+	free(tree_set(&wm->errors_by_sequence, cookie.sequence, expect));
+}
+
+void
+event_forget_error(struct wm *wm, xcb_void_cookie_t cookie)
+{
+	free(tree_pop(&wm->errors_by_sequence, cookie.sequence));
+}
+
+/* the server processed every request before this sequence without error */
+static void
+event_prune_errors(struct wm *wm, uint32_t sequence)
+{
+	uint64_t id;
+	void *iter;
+
+	for (;;) {
+		iter = NULL;
+		if (! tree_iter(&wm->errors_by_sequence, &iter, &id, NULL))
+			break;
+		if (id >= sequence)
+			break;
+		free(tree_xpop(&wm->errors_by_sequence, id));
 	}
-	xcb_key_symbols_free(ksyms);
 }
 
 static void
 event_process(struct wm *wm, xcb_generic_event_t *e)
 {
+	uint32_t	fields[2];
+	uint64_t	start = watchdog_clock();
+
+	if (trace_enabled) {
+		/* the first two fields after the sequence, usually windows */
+		memcpy(fields, (const char *)e + 4, sizeof fields);
+		trace_record(TRACE_EVENT, e->response_type & ~0x80,
+		    fields[0], fields[1], e->full_sequence);
+	}
+
+	event_prune_errors(wm, e->full_sequence);
+
 	switch (e->response_type & ~0x80) {
 	case XCB_KEY_PRESS:
 		on_key_press(wm, (xcb_key_press_event_t *)e);
@@ -337,6 +542,9 @@ event_process(struct wm *wm, xcb_generic_event_t *e)
 		break;
 
 	case 0:
+		on_error(wm, (xcb_generic_error_t *)e);
+		break;
+
 	case 1:
 		/* xproto.h documents opcodes starting at 2 */
 		break;
@@ -344,53 +552,259 @@ event_process(struct wm *wm, xcb_generic_event_t *e)
 	default:
 		log_warnx("received unknown event \"%d\"", e->response_type & ~0x80);
 	}
+
+	TRACE(TRACE_EVENT_DONE, e->response_type & ~0x80, 0, 0, e->full_sequence);
+	watchdog_event(e->response_type & ~0x80, start);
+}
+
+static void
+event_signals(struct wm *wm)
+{
+	struct signalfd_siginfo	si;
+
+	while (read(wm->signals, &si, sizeof si) == sizeof si) {
+		switch (si.ssi_signo) {
+		case SIGCHLD:
+			launcher_reap(wm);
+			break;
+		case SIGUSR1:
+			account_dump(wm);
+			watchdog_dump();
+			break;
+		case SIGUSR2:
+			trace_toggle();
+			break;
+		}
+	}
+}
+
+/*
+ * requests issued while handling a batch of events are written out in one
+ * go, the flush rate is reported when it exceeds the idle clock tick.
+ */
+static void
+event_flush(struct wm *wm)
+{
+	time_t now;
+
 	xcb_flush(wm->conn);
+	account_flush(wm);
+
+	now = time(NULL);
+	if (now != flushes_since) {
+		if (flushes > 1)
+			log_debug("flushes: %llu/s", (unsigned long long)flushes);
+		flushes_since = now;
+		flushes = 0;
+	}
+	flushes++;
+}
+
+/*
+ * the status clock has a one second resolution, sleep until the next wall
+ * clock second boundary rather than waking up at a fixed rate.
+ */
+static int
+event_timeout(void)
+{
+	struct timespec ts;
+	int timeout;
+	int remaining;
+
+	if (clock_gettime(CLOCK_REALTIME, &ts) == -1)
+		err(1, "clock_gettime");
+	timeout = 1000 - ts.tv_nsec / 1000000;
+
+	if (mode && (remaining = mode_remaining()) < timeout)
+		timeout = remaining;
+	return timeout;
+}
+
+static void
+event_intake(struct wm *wm)
+{
+	uint64_t	start = watchdog_clock();
+
+	record_mark(wm, RECORD_MARK_INTAKE);
+	TRACE_BEGIN(CLIENT_INTAKE);
+	client_place(wm);
+	TRACE_END(CLIENT_INTAKE);
+	watchdog_intake(start);
+}
+
+static void
+event_commit(struct wm *wm)
+{
+	uint64_t	start;
+
+	record_mark(wm, RECORD_MARK_COMMIT);
+	if (mode && mode_remaining() == 0) {
+		log_debug("mode timeout");
+		mode_leave(wm);
+	}
+	TRACE_BEGIN(COMMIT);
+	scene_commit(wm);
+	TRACE_END(COMMIT);
+	start = watchdog_clock();
+	TRACE_BEGIN(UPDATE);
+	layout_update(wm);
+	TRACE_END(UPDATE);
+	watchdog_update(start);
+	TRACE_BEGIN(RENDER);
+	window_render(wm);
+	TRACE_END(RENDER);
+	TRACE_BEGIN(FLUSH);
+	event_flush(wm);
+	TRACE_END(FLUSH);
+	watchdog_check(wm);
 }
 
 void
 event_loop(struct wm *wm)
 {
 	xcb_generic_event_t *e;
-	struct pollfd pfd[1];
+	struct pollfd pfd[2];
 	int nready;
 
 	pfd[0].fd = xcb_get_file_descriptor(wm->conn);
 	pfd[0].events = POLLIN;
+	pfd[1].fd = wm->signals;
+	pfd[1].events = POLLIN;
+
+	scene_commit(wm);
+	layout_update(wm);
+	window_render(wm);
+	event_flush(wm);
+	if (wm->startup_timing)
+		fion_startup_report(wm);
+	record_mark(wm, RECORD_MARK_START);
 	do {
-		/* tick every 0.1s */
-		nready = poll(pfd, 1, 1 * 100);
-		if (nready == -1)
+		nready = poll(pfd, 2, event_timeout());
+		if (nready == -1) {
+			if (errno == EINTR)
+				continue;
 			err(1, "poll");
-
-		if (nready) {
+		}
+		watchdog_start();
+		if (pfd[1].revents & POLLIN)
+			event_signals(wm);
+
+		/*
+		 * events may be queued while waiting for the replies needed
+		 * to place new clients, drain again until nothing is left.
+		 */
+		for (;;) {
 			while ((e = xcb_poll_for_event(wm->conn)) != NULL) {
+				record_event(e);
 				event_process(wm, e);
 				free(e);
 			}
+			if (TAILQ_EMPTY(&wm->intake_queue))
+				break;
+			event_intake(wm);
 		}
-		layout_update(wm);
-		xcb_flush(wm->conn);
+		event_commit(wm);
 	} while (running);
 }
 
+/*
+ * feed a recording through the handlers as fast as possible, the event
+ * loop is mimicked by the markers so the same batches are committed.
+ * sequences are those of the recorded session, they are shifted by the
+ * distance between its requests and ours at every marker so that our own
+ * ConfigureNotifys and expected errors are recognized as they were live.
+ */
+void
+event_replay(struct wm *wm, const struct replay *replay)
+{
+	xcb_generic_event_t	e;
+	struct timespec		start, end;
+	uint64_t		ns, calls, total;
+	uint32_t		offset = 0;
+	size_t			i, events = 0;
+	int			op;
+
+	scene_commit(wm);
+	layout_update(wm);
+	window_render(wm);
+	event_flush(wm);
+
+	trace_stats_start();
+	if (clock_gettime(CLOCK_MONOTONIC, &start) == -1)
+		err(1, "clock_gettime");
+	watchdog_start();
+	for (i = 0; i < replay->nevents; ++i) {
+		memcpy(&e, &replay->events[i], sizeof e);
+		if (e.response_type != RECORD_MARK) {
+			/* the only event without a sequence */
+			if ((e.response_type & ~0x80) != XCB_KEYMAP_NOTIFY) {
+				e.full_sequence += offset;
+				e.sequence = e.full_sequence;
+			}
+			event_process(wm, &e);
+			events++;
+			continue;
+		}
+
+		if (e.full_sequence)
+			offset = record_sequence(wm) - e.full_sequence;
+		if (e.pad0 == RECORD_MARK_INTAKE)
+			event_intake(wm);
+		else if (e.pad0 == RECORD_MARK_COMMIT) {
+			event_commit(wm);
+			watchdog_start();
+		}
+	}
+	if (clock_gettime(CLOCK_MONOTONIC, &end) == -1)
+		err(1, "clock_gettime");
+
+	ns = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000 +
+	    end.tv_nsec - start.tv_nsec;
+	printf("replay: %zu events in %.3fms, %.0f events/s\n", events,
+	    ns / 1e6, ns ? events * 1e9 / ns : 0.0);
+	for (op = 0; op < TRACE_OP_COUNT; ++op) {
+		trace_stats(op, &calls, &total);
+		if (calls)
+			printf("%s: %llu calls, %llu ns/call\n", trace_op_name(op),
+			    (unsigned long long)calls,
+			    (unsigned long long)(total / calls));
+	}
+}
+
+
+static void
+on_error(struct wm *wm, xcb_generic_error_t *ev)
+{
+	struct expect_error *expect;
+
+	expect = tree_pop(&wm->errors_by_sequence, ev->full_sequence);
+	if (expect == NULL) {
+		log_warnx("X error %d on request %d.%d (sequence %u)",
+		    ev->error_code, ev->major_code, ev->minor_code,
+		    ev->full_sequence);
+		return;
+	}
+
+	log_debug("on_error: %s failed with error %d", expect->op, ev->error_code);
+	expect->cb(wm, ev, expect->arg);
+	free(expect);
+}
 
 static void
 on_key_press(struct wm *wm, xcb_key_press_event_t *ev)
 {
-	xcb_key_symbols_t      *ksyms;
-	xcb_keysym_t		ksym;
-	int			i;
+	struct key	       *key;
 
-	ksyms = xcb_key_symbols_alloc(wm->conn);
-	ksym = xcb_key_symbols_get_keysym(ksyms, ev->detail, 0);
-	xcb_key_symbols_free(ksyms);
+	key = keymap[ev->detail][keymap_modidx(ev->state)];
+	if (key) {
+		key->cb(wm, ev->root);
+		return;
+	}
 
-	for (i = 0; (size_t)i < sizeof(keys) / sizeof(struct key); ++i)
-		if ((keys[i].mod == 0 || (ev->state & keys[i].mod)) && ksym == keys[i].ksym && keys[i].cb) {
-			keys[i].cb(wm, ev->root);
-			return;
-		}
-	mode = 0;
+	/* shift and friends may be pressed before the key ending the mode */
+	if (xcb_is_modifier_key(xcb_key_symbols_get_keysym(ksyms, ev->detail, 0)))
+		return;
+	mode_leave(wm);
 }
 
 static void
@@ -451,7 +865,11 @@ on_keymap_notify(struct wm *wm, xcb_keymap_notify_event_t *ev)
 static void
 on_expose(struct wm *wm, xcb_expose_event_t *ev)
 {
+	struct window *window = layout_window_get(wm, ev->window);
+
 	log_debug("on_expose");
+	if (window && ev->count == 0)
+		scene_expose(wm, window);
 }
 
 static void
@@ -479,9 +897,14 @@ on_create_notify(struct wm *wm, xcb_create_notify_event_t *ev)
 
 	log_debug("on_create_notify: %lld", (long long)ev->window);
 
+	/* menus, tooltips and other popups are none of our business */
+	if (ev->override_redirect)
+		return;
+
 	if (window == NULL) {
-		log_debug("creating new client window");
-		layout_client_create(wm, ev->parent, ev->window);
+		log_debug("requesting new client properties");
+		if (client_intake_get(wm, ev->window) == NULL)
+			client_intake(wm, ev->parent, ev->window);
 	}
 	else {
 		log_debug("reusing window... woops: %d", window->type);
@@ -492,7 +915,7 @@ static void
 on_destroy_notify(struct wm *wm, xcb_destroy_notify_event_t *ev)
 {
 	log_debug("on_destroy_notify: %lld", (long long)ev->window);
-	layout_client_destroy(wm, ev->window);
+	client_destroy(wm, ev->window);
 }
 
 static void
@@ -510,8 +933,19 @@ on_map_notify(struct wm *wm, xcb_map_notify_event_t *ev)
 static void
 on_map_request(struct wm *wm, xcb_map_request_event_t *ev)
 {
+	struct window *window = layout_window_get(wm, ev->window);
+	struct intake *intake;
+
 	/*log_debug("on_map_request");*/
-	xcb_map_window(wm->conn, ev->window);
+	if (window) {
+		layout_client_map(wm, window);
+		return;
+	}
+
+	/* placement is decided once the whole batch has been read */
+	if ((intake = client_intake_get(wm, ev->window)) == NULL)
+		intake = client_intake(wm, ev->parent, ev->window);
+	client_intake_queue(wm, intake);
 }
 
 static void
@@ -524,13 +958,15 @@ static void
 on_configure_notify(struct wm *wm, xcb_configure_notify_event_t *ev)
 {
 	log_debug("on_configure_notify: %d", ev->window);
-	layout_window_resize(wm, ev->window);
+	layout_window_configured(wm, ev->window, ev->sequence, ev->x, ev->y,
+	    ev->width, ev->height);
 }
 
 static void
 on_configure_request(struct wm *wm, xcb_configure_request_event_t *ev)
 {
-	log_debug("on_configure_request");
+	log_debug("on_configure_request: %d", ev->window);
+	client_configure(wm, ev);
 }
 
 static void
@@ -560,7 +996,10 @@ on_circulate_request(struct wm *wm, xcb_circulate_request_event_t *ev)
 static void
 on_property_notify(struct wm *wm, xcb_property_notify_event_t *ev)
 {
-	log_debug("on_property_notify");
+	const char *name = atom_name(ev->atom);
+
+	log_debug("on_property_notify: %u %s", ev->window, name ? name : "<unknown>");
+	client_intake_property(wm, ev);
 }
 
 static void
@@ -590,13 +1029,30 @@ on_colormap_notify(struct wm *wm, xcb_colormap_notify_event_t *ev)
 static void
 on_client_message(struct wm *wm, xcb_client_message_event_t *ev)
 {
-	log_debug("on_client_message");
+	const char *name = atom_name(ev->type);
+
+	log_debug("on_client_message: %u %s", ev->window, name ? name : "<unknown>");
 }
 
 static void
 on_mapping_notify(struct wm *wm, xcb_mapping_notify_event_t *ev)
 {
 	/*log_debug("on_mapping_notify");*/
+	void *iter;
+	struct window *screen;
+
+	if (xcb_refresh_keyboard_mapping(ksyms, ev) == 0)
+		return;
+
+	/* the mapping is requested again, the first lookup waits for it */
+	account_request(trace_current, XCB_GET_KEYBOARD_MAPPING,
+	    sizeof(xcb_get_keyboard_mapping_request_t), 0, 0);
+	account_roundtrip(wm);
+	keymap_build(wm, ev->first_keycode, ev->count);
+
+	iter = NULL;
+	while (tree_iter(&wm->screens_by_window, &iter, NULL, (void **)&screen))
+		event_grab_keys(wm, screen);
 }
 
 static void	on_ge_generic(struct wm *wm, xcb_ge_generic_event_t *ev)
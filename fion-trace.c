@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * fion-trace decodes the file written by fion -t, as a timeline by default
+ * or as per operation latency histograms with -H.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hist.h"
+#include "proto.h"
+#include "trace.h"
+
+static const char *
+op_name(uint8_t opcode)
+{
+	if (opcode < TRACE_OP_COUNT)
+		return trace_op_name(opcode);
+	return "op";
+}
+
+static void
+hist_print(const char *name, const struct hist *hist)
+{
+	uint64_t	peak = 0;
+	int		i;
+
+	if (hist->count == 0)
+		return;
+
+	for (i = 0; i < HIST_BUCKETS; ++i)
+		if (hist->buckets[i] > peak)
+			peak = hist->buckets[i];
+
+	printf("%s: %" PRIu64 " calls, avg %" PRIu64 "ns, p50 %" PRIu64 "ns,"
+	    " p99 %" PRIu64 "ns, max %" PRIu64 "ns\n",
+	    name, hist->count, hist->total / hist->count,
+	    hist_percentile(hist, 50), hist_percentile(hist, 99), hist->max);
+	for (i = 0; i < HIST_BUCKETS; ++i)
+		if (hist->buckets[i])
+			printf("  %10" PRIu64 "ns %8" PRIu64 " %.*s\n",
+			    hist_value(i), hist->buckets[i],
+			    (int)(hist->buckets[i] * 50 / peak),
+			    "##################################################");
+}
+
+static void
+timeline(const struct trace_record *rec, uint64_t base)
+{
+	double	ms = (rec->ns - base) / 1e6;
+
+	switch (rec->kind) {
+	case TRACE_EVENT:
+		printf("%12.3f event   %-20s %08x %08x seq %u\n", ms,
+		    proto_event_name(rec->opcode), rec->a, rec->b, rec->c);
+		break;
+	case TRACE_EVENT_DONE:
+		break;
+	case TRACE_REQUEST:
+		printf("%12.3f request %-20s %08x seq %u for %s\n", ms,
+		    proto_request_name(rec->opcode), rec->a, rec->c,
+		    rec->b == TRACE_OP_NONE ? "other" : op_name(rec->b));
+		break;
+	case TRACE_OP_BEGIN:
+		printf("%12.3f begin   %s\n", ms, op_name(rec->opcode));
+		break;
+	case TRACE_OP_END:
+		printf("%12.3f end     %s\n", ms, op_name(rec->opcode));
+		break;
+	default:
+		printf("%12.3f unknown record kind %d\n", ms, rec->kind);
+	}
+}
+
+static void
+usage(void)
+{
+	extern char *__progname;
+
+	fprintf(stderr, "usage: %s [-H] tracefile\n", __progname);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct hist		 ops[TRACE_OP_COUNT], events[256];
+	uint64_t		 op_start[TRACE_OP_COUNT], event_start[256];
+	const struct trace_header *header;
+	const struct trace_record *records, *rec;
+	struct stat		 sb;
+	uint64_t		 first, i;
+	void			*p;
+	int			 fd, ch, hflag = 0;
+
+	while ((ch = getopt(argc, argv, "H")) != -1) {
+		switch (ch) {
+		case 'H':
+			hflag = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 1)
+		usage();
+
+	if ((fd = open(argv[0], O_RDONLY)) == -1)
+		err(1, "%s", argv[0]);
+	if (fstat(fd, &sb) == -1)
+		err(1, "fstat");
+	if ((size_t)sb.st_size < sizeof *header)
+		errx(1, "%s: truncated trace", argv[0]);
+	if ((p = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		err(1, "mmap");
+	close(fd);
+
+	header = p;
+	records = (const struct trace_record *)(header + 1);
+	if (memcmp(header->magic, TRACE_MAGIC, sizeof header->magic) != 0 ||
+	    header->record_size != sizeof *records ||
+	    sizeof *header + (uint64_t)header->capacity * sizeof *records > (uint64_t)sb.st_size)
+		errx(1, "%s: not a fion trace", argv[0]);
+
+	/* once the ring wrapped, the oldest record follows the newest */
+	first = header->count > header->capacity ? header->count - header->capacity : 0;
+	if (first != 0)
+		fprintf(stderr, "%" PRIu64 " oldest records were overwritten\n", first);
+
+	memset(ops, 0, sizeof ops);
+	memset(events, 0, sizeof events);
+	memset(op_start, 0, sizeof op_start);
+	memset(event_start, 0, sizeof event_start);
+	for (i = first; i < header->count; ++i) {
+		rec = &records[i % header->capacity];
+		if (!hflag) {
+			timeline(rec, records[first % header->capacity].ns);
+			continue;
+		}
+
+		switch (rec->kind) {
+		case TRACE_EVENT:
+			event_start[rec->opcode] = rec->ns;
+			break;
+		case TRACE_EVENT_DONE:
+			if (event_start[rec->opcode])
+				hist_add(&events[rec->opcode], rec->ns - event_start[rec->opcode]);
+			event_start[rec->opcode] = 0;
+			break;
+		case TRACE_OP_BEGIN:
+			if (rec->opcode < TRACE_OP_COUNT)
+				op_start[rec->opcode] = rec->ns;
+			break;
+		case TRACE_OP_END:
+			if (rec->opcode < TRACE_OP_COUNT && op_start[rec->opcode])
+				hist_add(&ops[rec->opcode], rec->ns - op_start[rec->opcode]);
+			if (rec->opcode < TRACE_OP_COUNT)
+				op_start[rec->opcode] = 0;
+			break;
+		}
+	}
+
+	if (hflag) {
+		for (i = 0; i < TRACE_OP_COUNT; ++i)
+			hist_print(trace_op_name(i), &ops[i]);
+		for (i = 0; i < 256; ++i)
+			hist_print(proto_event_name(i), &events[i]);
+	}
+
+	munmap(p, sb.st_size);
+	return 0;
+}
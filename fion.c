@@ -14,6 +14,7 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <sys/signalfd.h>
 #include <sys/wait.h>
 
 #include <err.h>
@@ -24,6 +25,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <xcb/xcbext.h>
+
 #include "fion.h"
 #include "log.h"
 
@@ -31,6 +34,7 @@
 static void	fion_init(struct wm *);
 static void	fion_done(struct wm *);
 static void	fion_setup(struct wm *);
+static void	fion_signals(struct wm *);
 static void	usage(void);
 
 extern char *__progname;
@@ -38,21 +42,50 @@ extern char *__progname;
 static void
 usage(void)
 {
-	err(1, "usage: %s [-d]", __progname);
+	err(1, "usage: %s [-dT] [-P replayfile] [-R recordfile] [-t tracefile] [-w budget]", __progname);
 }
 
 int
 main(int argc, char *argv[])
 {
 	struct wm wm;
+	const char *tracefile = NULL;
+	const char *recordfile = NULL;
+	const char *replayfile = NULL;
+	struct replay replay;
+	char *ep;
+	long budget;
 	int dflag, ch;
 	
+	memset(&wm, 0, sizeof wm);
+	wm.generate_id = window_generate_id;
+	if (clock_gettime(CLOCK_MONOTONIC, &wm.startup) == -1)
+		err(1, "clock_gettime");
+
 	dflag = 0;
-	while ((ch = getopt(argc, argv, "d")) != -1) {
+	while ((ch = getopt(argc, argv, "dP:R:Tt:w:")) != -1) {
 		switch (ch) {
 		case 'd':
 			dflag = 1;
 			break;
+		case 'T':
+			wm.startup_timing = 1;
+			break;
+		case 'P':
+			replayfile = optarg;
+			break;
+		case 'R':
+			recordfile = optarg;
+			break;
+		case 't':
+			tracefile = optarg;
+			break;
+		case 'w':
+			budget = strtol(optarg, &ep, 10);
+			if (*optarg == '\0' || *ep != '\0' || budget < 0 || budget > 60000)
+				errx(1, "invalid watchdog budget: %s", optarg);
+			watchdog_budget(budget);
+			break;
 		default:
 			usage();
 		}
@@ -67,8 +100,33 @@ main(int argc, char *argv[])
 
 	log_info("started");
 
+	if (tracefile && trace_open(tracefile) == -1)
+		errx(1, "could not open trace file %s", tracefile);
+
+	/* no display, no launcher: the recording drives a stub connection */
+	if (replayfile) {
+		if (record_load(replayfile, &replay) == -1)
+			errx(1, "could not load recording %s", replayfile);
+		wm.launcher = -1;
+		wm.conn = stub_connect(&replay);
+		fion_setup(&wm);
+		event_replay(&wm, &replay);
+		if (dflag) {
+			account_dump(&wm);
+			watchdog_dump();
+		}
+		fion_done(&wm);
+		return 0;
+	}
+
+	/* before the X connection is opened so that it is not inherited */
+	fion_signals(&wm);
+	launcher_init(&wm);
+	log_async_start();
 	fion_init(&wm);
 	fion_setup(&wm);
+	if (recordfile)
+		record_open(&wm, recordfile);
 
 #if 0
 	if (pledge("stdio proc exec", NULL) == -1)
@@ -77,11 +135,69 @@ main(int argc, char *argv[])
 
 	event_loop(&wm);
 
+	if (dflag) {
+		account_dump(&wm);
+		watchdog_dump();
+	}
 	fion_done(&wm);
 	log_info("exiting");
 	return 0;
 }
 
+/*
+ * xcb_request_check() variant that does not block when the outcome of the
+ * request is already known, round trips that could not be avoided are
+ * accounted for.
+ */
+xcb_generic_error_t *
+fion_request_check(struct wm *wm, xcb_void_cookie_t cookie)
+{
+	xcb_generic_error_t *error = NULL;
+	void *reply = NULL;
+
+	if (xcb_poll_for_reply(wm->conn, cookie.sequence, &reply, &error)) {
+		free(reply);
+		return error;
+	}
+	account_roundtrip(wm);
+	return xcb_request_check(wm->conn, cookie);
+}
+
+/* the same for replies, which are NULL on error */
+void *
+fion_reply(struct wm *wm, unsigned int sequence)
+{
+	xcb_generic_error_t *error = NULL;
+	void *reply = NULL;
+
+	if (! xcb_poll_for_reply(wm->conn, sequence, &reply, &error)) {
+		account_roundtrip(wm);
+		reply = xcb_wait_for_reply(wm->conn, sequence, &error);
+	}
+	free(error);
+	return reply;
+}
+
+/* called once the first layout has been flushed */
+void
+fion_startup_report(struct wm *wm)
+{
+	struct timespec now;
+	uint64_t roundtrips = wm->roundtrips;
+
+	/* wait for the server to have processed the first paint */
+	free(xcb_get_input_focus_reply(wm->conn,
+		xcb_get_input_focus(wm->conn), NULL));
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == -1)
+		err(1, "clock_gettime");
+
+	fprintf(stderr, "startup: %llu round trips, %.3fms to first paint\n",
+	    (unsigned long long)roundtrips,
+	    (now.tv_sec - wm->startup.tv_sec) * 1e3 +
+	    (now.tv_nsec - wm->startup.tv_nsec) / 1e6);
+}
+
 static void
 fion_init(struct wm *wm)
 {
@@ -93,13 +209,45 @@ fion_init(struct wm *wm)
 static void
 fion_done(struct wm *wm)
 {
+	window_finalize(wm);
 	xcb_disconnect(wm->conn);
+	launcher_done(wm);
+	record_close();
+	trace_close();
+}
+
+/*
+ * signals are blocked and read from a signalfd polled by the event loop,
+ * SIGCHLD reports the launcher exiting, SIGUSR1 dumps the request accounting
+ * and handler latencies, SIGUSR2 toggles tracing.
+ */
+static void
+fion_signals(struct wm *wm)
+{
+	sigset_t	mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+		err(1, "sigprocmask");
+	if ((wm->signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1)
+		err(1, "signalfd");
 }
 
+/*
+ * every request needed to take over the screens is issued before any of
+ * their outcome is looked at, the keyboard mapping fetched by event_init()
+ * is the only reply waited for, atoms and errors are collected afterwards.  other
+ * requests report their errors asynchronously through event_process().
+ */
 static void
 fion_setup(struct wm *wm)
 {
 	xcb_screen_iterator_t iter;
+	xcb_void_cookie_t *cookies;
+	xcb_generic_error_t *error;
 	uint64_t screen_id = 0;
 	uint32_t value =
 	    XCB_EVENT_MASK_KEY_PRESS |
@@ -108,14 +256,37 @@ fion_setup(struct wm *wm)
 	    XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT;
 
 	layout_init(wm);
+	atom_intern(wm);
+
 	iter = xcb_setup_roots_iterator(xcb_get_setup(wm->conn));
+	if ((cookies = calloc(iter.rem, sizeof(*cookies))) == NULL)
+		err(1, "fion_setup: calloc");
+
 	for (; iter.rem; screen_id++, xcb_screen_next(&iter)) {
-		if (xcb_request_check(wm->conn,
-			xcb_change_window_attributes_checked(wm->conn,
-			    iter.data->root,
-			    XCB_CW_EVENT_MASK, &value)))
-			err(1, "fion_setup");
-		layout_screen_register(wm, iter.data);
+		cookies[screen_id] = xcb_change_window_attributes_checked(wm->conn,
+		    iter.data->root,
+		    XCB_CW_EVENT_MASK, &value);
+		account_request(trace_current, XCB_CHANGE_WINDOW_ATTRIBUTES,
+		    sizeof(xcb_change_window_attributes_request_t) + 4,
+		    iter.data->root, cookies[screen_id].sequence);
+		layout_screen_register(wm, iter.data, iter.data->root,
+		    iter.data->width_in_pixels, iter.data->height_in_pixels);
 	}
 	layout_screen_render(wm);
+
+	event_init(wm);
+	atom_collect(wm);
+
+	screen_id = 0;
+	iter = xcb_setup_roots_iterator(xcb_get_setup(wm->conn));
+	for (; iter.rem; screen_id++, xcb_screen_next(&iter)) {
+		if ((error = fion_request_check(wm, cookies[screen_id])) != NULL)
+			errx(1, "fion_setup: screen %llu is already managed",
+			    (unsigned long long)screen_id);
+		event_grab_keys(wm, layout_window_get(wm, iter.data->root));
+	}
+
+	client_adopt(wm);
+
+	free(cookies);
 }
@@ -19,74 +19,145 @@
 #include <xcb/xcb_keysyms.h>
 #include <X11/keysym.h>
 
-#include "tree.h"
-
-#define	BORDER_WIDTH			1
-#define	BORDER_SCREEN_WIDTH		0
-#define	BORDER_STATUS_WIDTH		1
-#define	BORDER_WORKAREA_WIDTH		1
-#define	BORDER_WORKSPACE_WIDTH		1
-#define	BORDER_TILEFORK_WIDTH		0
-#define	BORDER_TILE_WIDTH		1
-#define	BORDER_TILE_ACTIVE_WIDTH       	1
-
-#define	STATUS_HEIGHT	16
-
-enum split {
-	HSPLIT,
-	VSPLIT,
+#include "layout.h"
+
+#define	STATUS_FONT	"7x13"
+
+#define	WATCHDOG_BUDGET	8	/* ms per event loop iteration, see -w */
+
+/* atoms interned at startup, accessible as atoms[ATOM_name] */
+#define	ATOMS(X)				\
+	X(UTF8_STRING)				\
+	X(WM_CLASS)				\
+	X(WM_NAME)				\
+	X(WM_HINTS)				\
+	X(WM_NORMAL_HINTS)			\
+	X(WM_TRANSIENT_FOR)			\
+	X(WM_PROTOCOLS)				\
+	X(WM_DELETE_WINDOW)			\
+	X(WM_TAKE_FOCUS)			\
+	X(WM_STATE)				\
+	X(_NET_SUPPORTED)			\
+	X(_NET_SUPPORTING_WM_CHECK)		\
+	X(_NET_ACTIVE_WINDOW)			\
+	X(_NET_CLIENT_LIST)			\
+	X(_NET_WM_NAME)				\
+	X(_NET_WM_STATE)			\
+	X(_NET_WM_STATE_FULLSCREEN)		\
+	X(_NET_WM_WINDOW_TYPE)			\
+	X(_NET_WM_WINDOW_TYPE_NORMAL)		\
+	X(_NET_WM_WINDOW_TYPE_DIALOG)		\
+	X(_NET_WM_WINDOW_TYPE_UTILITY)		\
+	X(_NET_WM_WINDOW_TYPE_SPLASH)		\
+	X(_NET_WM_WINDOW_TYPE_DOCK)		\
+	X(_NET_WM_WINDOW_TYPE_MENU)		\
+	X(_NET_WM_WINDOW_TYPE_DROPDOWN_MENU)	\
+	X(_NET_WM_WINDOW_TYPE_POPUP_MENU)	\
+	X(_NET_WM_WINDOW_TYPE_TOOLTIP)		\
+	X(_NET_WM_WINDOW_TYPE_NOTIFICATION)
+
+enum atom {
+#define	X(name)	ATOM_##name,
+	ATOMS(X)
+#undef	X
+	ATOM_COUNT
 };
 
-enum window_type {
-	WT_SCREEN,
-	WT_STATUSBAR,
-	WT_WORKAREA,
-	WT_WORKSPACE,
-	WT_TILEFORK,
-	WT_TILE,
-	WT_FRAME,
-	WT_CLIENT,
-};
-
-struct wm {
-	xcb_connection_t *conn;
-
-	struct tree windows;
-
-	struct tree screens_by_id;
-	struct tree screens_by_window;
+extern xcb_atom_t	atoms[ATOM_COUNT];
 
-	struct tree tiles_by_id;
-	struct tree tiles_by_window;
+struct render {
+	char		       *font_name;
+	xcb_gcontext_t		gc;
 
-	struct tree curr_workarea;
-	struct tree curr_status;
-	struct tree curr_workspace;
-	struct tree curr_tile;
-	struct tree curr_frame;
-
-	struct window *active_screen;
+	int			failed;
+	xcb_void_cookie_t	cookie_font;
+	xcb_void_cookie_t	cookie_gc;
 };
 
-struct window {
-	uint64_t		winid;
-	uint64_t		objid;
-
-	enum window_type        type;
+enum intake_class {
+	INTAKE_GONE,
+	INTAKE_IGNORE,
+	INTAKE_FLOAT,
+	INTAKE_MANAGE,
+};
 
-    int	x;
-    int	y;
-    int	width;
-    int	height;
-	int	border_width;
+struct intake {
+	xcb_window_t		xcb_root;
+	xcb_window_t		xcb_window;
+
+	int			queued;
+	TAILQ_ENTRY(intake)	entry;
+
+	xcb_get_window_attributes_cookie_t cookie_attr;
+	xcb_get_property_cookie_t cookie_class;
+	xcb_get_property_cookie_t cookie_name;
+	xcb_get_property_cookie_t cookie_net_name;
+	xcb_get_property_cookie_t cookie_hints;
+	xcb_get_property_cookie_t cookie_normal_hints;
+	xcb_get_property_cookie_t cookie_transient_for;
+	xcb_get_property_cookie_t cookie_protocols;
+	xcb_get_property_cookie_t cookie_type;
+
+	/* valid once resolved, refreshed when the properties change */
+	int			gone;
+	int			override_redirect;
+	int			input_only;
+	int			viewable;
+	char		       *instance;
+	char		       *class;
+	char		       *name;
+	char		       *net_name;
+	int			has_hints;
+	xcb_icccm_wm_hints_t	hints;
+	int			has_normal_hints;
+	xcb_size_hints_t	normal_hints;
+	xcb_window_t		transient_for;
+	int			delete_window;
+	int			take_focus;
+	xcb_atom_t		type;
+};
 
-	struct tree		children;
+typedef void (*error_cb)(struct wm *, xcb_generic_error_t *, void *);
 
-        xcb_screen_t           *xcb_screen;
-        xcb_window_t            xcb_parent;
-        xcb_window_t            xcb_window;
+/*
+ * recordings hold the setup of the X server, its keyboard mapping, then
+ * the events read by the event loop.  markers use a response type that is
+ * never an event and tell where the loop started, clients were placed and
+ * the layout committed.  each marker carries the sequence of a NoOperation
+ * request sent when it was written, replays send theirs at the same point
+ * to rebase the sequences of the events that follow on their own requests.
+ */
+#define	RECORD_MAGIC		"FIONREC1"
+#define	RECORD_SCREENS_MAX	8
+#define	RECORD_MARK		1
+#define	RECORD_MARK_INTAKE	0
+#define	RECORD_MARK_COMMIT	1
+#define	RECORD_MARK_START	2
+
+struct record_header {
+	char		magic[8];
+	uint32_t	resource_id_base;
+	uint32_t	resource_id_mask;
+	uint8_t		min_keycode;
+	uint8_t		max_keycode;
+	uint8_t		keysyms_per_keycode;
+	uint8_t		nscreens;
+	struct {
+		uint32_t	root;
+		uint32_t	root_visual;
+		uint16_t	width;
+		uint16_t	height;
+		uint8_t		root_depth;
+		uint8_t		pad[3];
+	} screens[RECORD_SCREENS_MAX];
 };
 
+struct replay {
+	const struct record_header     *header;
+	const xcb_keysym_t	       *keysyms;
+	const xcb_generic_event_t      *events;
+	size_t				nevents;
+};
 
 struct key {
 	unsigned int		mod;
@@ -95,65 +166,89 @@ struct key {
 };
 
 
+/* atom.c */
+void		 atom_intern(struct wm *wm);
+void		 atom_collect(struct wm *wm);
+const char	*atom_name(xcb_atom_t atom);
+
+
+/* client.c */
+struct intake	*client_intake(struct wm *wm, xcb_window_t xcb_root, xcb_window_t xcb_window);
+struct intake	*client_intake_get(struct wm *wm, xcb_window_t xcb_window);
+void		 client_intake_queue(struct wm *wm, struct intake *intake);
+void		 client_intake_property(struct wm *wm, xcb_property_notify_event_t *ev);
+enum intake_class client_intake_classify(struct intake *intake);
+void		 client_adopt(struct wm *wm);
+void		 client_place(struct wm *wm);
+void		 client_configure(struct wm *wm, xcb_configure_request_event_t *ev);
+void		 client_destroy(struct wm *wm, xcb_window_t xcb_window);
+void		 client_intake_resolve(struct wm *wm, struct intake *intake);
+void		 client_intake_done(struct wm *wm, struct intake *intake);
+void		 client_intake_free(struct wm *wm, struct intake *intake);
+
+
+/* fion.c */
+xcb_generic_error_t *fion_request_check(struct wm *wm, xcb_void_cookie_t cookie);
+void		*fion_reply(struct wm *wm, unsigned int sequence);
+void		 fion_startup_report(struct wm *wm);
+
+
 /* event.c */
+void		 event_init(struct wm *wm);
 void		 event_loop(struct wm *wm);
+void		 event_replay(struct wm *wm, const struct replay *replay);
 void		 event_grab_keys(struct wm *wm, struct window *screen);
+void		 event_expect_error(struct wm *wm, xcb_void_cookie_t cookie, const char *op, error_cb cb, void *arg);
+void		 event_forget_error(struct wm *wm, xcb_void_cookie_t cookie);
 
 
-/* layout.c */
-void		 layout_init(struct wm *wm);
-void		 layout_screen_add(struct wm *wm, xcb_screen_t *xcb_screen);
-void		 layout_finalize(struct wm *wm);
-struct window	*layout_window_get(struct wm *wm, xcb_window_t xcb_window);
-struct window	*layout_frame_get_current(struct wm *wm);
-int		 layout_window_exists(struct wm *wm, xcb_window_t xcb_window);
-struct window	*layout_client_create(struct wm *wm, xcb_window_t xcb_root, xcb_window_t xcb_window);
-void		 layout_window_remove(struct wm *wm, xcb_window_t xcb_window);
+/* window.c */
+xcb_window_t	 window_generate_id(struct wm *wm);
+void		 window_render(struct wm *wm);
+void		 window_finalize(struct wm *wm);
+void		 window_raise(struct wm *wm, struct window *window);
+void		 window_configure_notify(struct wm *wm, struct window *window);
+void		 window_border_width(struct wm *wm, struct window *window, uint32_t width);
 
-void		 layout_workspace_create(struct wm *wm, xcb_window_t xcb_root);
-void		 layout_workspace_next(struct wm *wm, xcb_window_t xcb_root);
-void		 layout_workspace_prev(struct wm *wm, xcb_window_t xcb_root);
-void		 layout_workspace_destroy(struct wm *wm, xcb_window_t xcb_root);
 
-void		 layout_screen_register(struct wm *wm, xcb_screen_t *xcb_screen);
-void		 layout_screen_render(struct wm *wm);
+/* account.c */
+void		 account_request(int cause, uint8_t opcode, size_t length, uint32_t resource, unsigned int sequence);
+void		 account_roundtrip(struct wm *wm);
+void		 account_flush(struct wm *wm);
+void		 account_dump(struct wm *wm);
+void		 account_iteration(char *buf, size_t size);
 
-void		 layout_tile_prev(struct wm *wm, xcb_window_t xcb_root);
-void		 layout_tile_next(struct wm *wm, xcb_window_t xcb_root);
-void		 layout_tile_destroy(struct wm *wm, xcb_window_t xcb_root);
 
-void		 layout_frame_prev(struct wm *wm, xcb_window_t xcb_root);
-void		 layout_frame_next(struct wm *wm, xcb_window_t xcb_root);
+/* watchdog.c */
+uint64_t	 watchdog_clock(void);
+void		 watchdog_budget(int ms);
+void		 watchdog_start(void);
+void		 watchdog_event(uint8_t type, uint64_t start);
+void		 watchdog_intake(uint64_t start);
+void		 watchdog_update(uint64_t start);
+void		 watchdog_check(struct wm *wm);
+void		 watchdog_dump(void);
 
-void		 layout_tile_split(struct wm *wm, xcb_window_t xcb_root, enum split direction);
-void		 layout_client_resize(struct wm *wm, struct window *client);
-void		 layout_update(struct wm *wm);
-void		 layout_update_status(struct wm *wm, struct window *status);
-void		 layout_tile_set_active(struct wm *wm, xcb_window_t window);
-void		 layout_client_destroy(struct wm *wm, xcb_window_t xcb_window);
-void		 layout_window_resize(struct wm *wm, xcb_window_t window);
 
+/* launcher.c */
+void		 launcher_init(struct wm *wm);
+void		 launcher_done(struct wm *wm);
+void		 launcher_spawn(struct wm *wm, const char *const argv[]);
+void		 launcher_reap(struct wm *wm);
+
+
+/* record.c */
+void		 record_open(struct wm *wm, const char *path);
+void		 record_close(void);
+void		 record_event(const xcb_generic_event_t *e);
+void		 record_mark(struct wm *wm, uint8_t mark);
+unsigned int	 record_sequence(struct wm *wm);
+int		 record_load(const char *path, struct replay *replay);
+
+
+/* stub.c */
+xcb_connection_t *stub_connect(const struct replay *replay);
 
-/* window.c */
-struct window	*window_create(struct wm *wm, enum window_type wt, struct window *parent);
-struct window	*window_create_root(struct wm *wm, struct window *window);
-struct window	*window_create_screen(struct wm *wm, struct window *window);
-struct window	*window_create_status(struct wm *wm, struct window *window);
-struct window	*window_create_workarea(struct wm *wm, struct window *window);
-struct window	*window_create_workspace(struct wm *wm, struct window *window);
-struct window	*window_create_tilefork(struct wm *wm, struct window *window);
-struct window	*window_create_tile(struct wm *wm, struct window *window);
-struct window	*window_create_frame(struct wm *wm, struct window *window);
-struct window	*window_create_client(struct wm *wm, struct window *window);
-
-void		 window_map(struct wm *wm, struct window *window);
-void		 window_unmap(struct wm *wm, struct window *window);
-void		 window_destroy(struct wm *wm, struct window *window);
-void		 window_raise(struct wm *wm, struct window *window);
-void		 window_reparent(struct wm *wm, struct window *parent, struct window *window);
-void		 window_resize(struct wm *wm, struct window *window);
-void		 window_border_color(struct wm *wm, struct window *window, const char *rgb);
-void		 window_border_width(struct wm *wm, struct window *window, uint32_t width);
 
 /* wm.c */
 void		 wm_workspace_create(struct wm *wm, xcb_window_t xcb_root);
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * open addressing hash table with linear probing, keyed by uint64_t.
+ *
+ * unlike the splay tree, lookups never modify the table.  removal uses
+ * backward shifting so that no tombstones are left behind.
+ */
+
+#include <sys/types.h>
+
+#include <err.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "hash.h"
+
+#define	HASH_MINSIZE	16
+
+struct hashentry {
+	uint64_t		 id;
+	void			*data;
+	int			 used;
+};
+
+static size_t hash_slot(struct hash *, uint64_t);
+static struct hashentry *hash_find(struct hash *, uint64_t);
+static void hash_grow(struct hash *);
+static void hash_remove(struct hash *, struct hashentry *);
+
+static size_t
+hash_slot(struct hash *h, uint64_t id)
+{
+	id ^= id >> 33;
+	id *= 0xff51afd7ed558ccdULL;
+	id ^= id >> 33;
+	return (id & (h->size - 1));
+}
+
+static struct hashentry *
+hash_find(struct hash *h, uint64_t id)
+{
+	struct hashentry	*entry;
+	size_t			 i;
+
+	if (h->size == 0)
+		return (NULL);
+
+	for (i = hash_slot(h, id);; i = (i + 1) & (h->size - 1)) {
+		entry = &h->table[i];
+		if (!entry->used)
+			return (NULL);
+		if (entry->id == id)
+			return (entry);
+	}
+}
+
+static void
+hash_grow(struct hash *h)
+{
+	struct hashentry	*old, *entry;
+	size_t			 oldsize, i, j;
+
+	old = h->table;
+	oldsize = h->size;
+
+	h->size = oldsize ? oldsize * 2 : HASH_MINSIZE;
+	if ((h->table = calloc(h->size, sizeof *h->table)) == NULL)
+		err(1, "hash_grow: calloc");
+
+	for (i = 0; i < oldsize; ++i) {
+		if (!old[i].used)
+			continue;
+		for (j = hash_slot(h, old[i].id);; j = (j + 1) & (h->size - 1)) {
+			entry = &h->table[j];
+			if (!entry->used) {
+				*entry = old[i];
+				break;
+			}
+		}
+	}
+	free(old);
+}
+
+static void
+hash_remove(struct hash *h, struct hashentry *entry)
+{
+	size_t	i, j, k;
+
+	i = entry - h->table;
+	h->table[i].used = 0;
+	h->count -= 1;
+
+	for (j = (i + 1) & (h->size - 1); h->table[j].used;
+	     j = (j + 1) & (h->size - 1)) {
+		k = hash_slot(h, h->table[j].id);
+		/* entry stays if its home slot lies cyclically in (i, j] */
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		h->table[i] = h->table[j];
+		h->table[j].used = 0;
+		i = j;
+	}
+}
+
+void
+hash_free(struct hash *h)
+{
+	free(h->table);
+	hash_init(h);
+}
+
+int
+hash_check(struct hash *h, uint64_t id)
+{
+	return (hash_find(h, id) != NULL);
+}
+
+void *
+hash_set(struct hash *h, uint64_t id, void *data)
+{
+	struct hashentry	*entry;
+	void			*old;
+	size_t			 i;
+
+	if ((entry = hash_find(h, id)) != NULL) {
+		old = entry->data;
+		entry->data = data;
+		return (old);
+	}
+
+	/* keep the load factor under 3/4 */
+	if ((h->count + 1) * 4 > h->size * 3)
+		hash_grow(h);
+
+	for (i = hash_slot(h, id); h->table[i].used; i = (i + 1) & (h->size - 1))
+		;
+	entry = &h->table[i];
+	entry->id = id;
+	entry->data = data;
+	entry->used = 1;
+	h->count += 1;
+
+	return (NULL);
+}
+
+void
+hash_xset(struct hash *h, uint64_t id, void *data)
+{
+	if (hash_find(h, id) != NULL)
+		errx(1, "hash_xset(%p, 0x%016"PRIx64 ")", h, id);
+	hash_set(h, id, data);
+}
+
+void *
+hash_get(struct hash *h, uint64_t id)
+{
+	struct hashentry	*entry;
+
+	if ((entry = hash_find(h, id)) == NULL)
+		return (NULL);
+
+	return (entry->data);
+}
+
+void *
+hash_xget(struct hash *h, uint64_t id)
+{
+	struct hashentry	*entry;
+
+	if ((entry = hash_find(h, id)) == NULL)
+		errx(1, "hash_get(%p, 0x%016"PRIx64 ")", h, id);
+
+	return (entry->data);
+}
+
+void *
+hash_pop(struct hash *h, uint64_t id)
+{
+	struct hashentry	*entry;
+	void			*data;
+
+	if ((entry = hash_find(h, id)) == NULL)
+		return (NULL);
+
+	data = entry->data;
+	hash_remove(h, entry);
+
+	return (data);
+}
+
+void *
+hash_xpop(struct hash *h, uint64_t id)
+{
+	struct hashentry	*entry;
+	void			*data;
+
+	if ((entry = hash_find(h, id)) == NULL)
+		errx(1, "hash_xpop(%p, 0x%016" PRIx64 ")", h, id);
+
+	data = entry->data;
+	hash_remove(h, entry);
+
+	return (data);
+}
+
+/* iteration order is unspecified and the table must not be modified meanwhile */
+int
+hash_iter(struct hash *h, void **hdl, uint64_t *id, void **data)
+{
+	struct hashentry	*curr = *hdl;
+
+	curr = curr ? curr + 1 : h->table;
+	for (; curr && curr < h->table + h->size; ++curr) {
+		if (!curr->used)
+			continue;
+		*hdl = curr;
+		if (id)
+			*id = curr->id;
+		if (data)
+			*data = curr->data;
+		return (1);
+	}
+
+	return (0);
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HASH_H_
+#define	_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct hashentry;
+
+struct hash {
+	struct hashentry	*table;
+	size_t			 size;
+	size_t			 count;
+};
+
+#define hash_init(h) do { (h)->table = NULL; (h)->size = 0; (h)->count = 0; } while(0)
+#define hash_empty(h) ((h)->count == 0)
+#define hash_count(h) ((h)->count)
+void hash_free(struct hash *);
+int hash_check(struct hash *, uint64_t);
+void *hash_set(struct hash *, uint64_t, void *);
+void hash_xset(struct hash *, uint64_t, void *);
+void *hash_get(struct hash *, uint64_t);
+void *hash_xget(struct hash *, uint64_t);
+void *hash_pop(struct hash *, uint64_t);
+void *hash_xpop(struct hash *, uint64_t);
+int hash_iter(struct hash *, void **, uint64_t *, void **);
+
+#endif
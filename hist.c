@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * latency histograms, shared by the watchdog and fion-trace.
+ */
+
+#include "hist.h"
+
+static int	hist_bucket(uint64_t);
+
+static int
+hist_bucket(uint64_t ns)
+{
+	int	bits;
+
+	if (ns < HIST_SUB)
+		return ns;
+	bits = 63 - __builtin_clzll(ns);
+	if (bits > HIST_MAX_BITS)
+		return HIST_BUCKETS - 1;
+	return ((bits - HIST_SUB_BITS + 1) << HIST_SUB_BITS) +
+	    ((ns >> (bits - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+/* lowest value falling into a bucket */
+uint64_t
+hist_value(int bucket)
+{
+	int	bits;
+
+	if (bucket < HIST_SUB)
+		return bucket;
+	bits = (bucket >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+	return (uint64_t)(HIST_SUB + (bucket & (HIST_SUB - 1))) <<
+	    (bits - HIST_SUB_BITS);
+}
+
+void
+hist_add(struct hist *hist, uint64_t ns)
+{
+	hist->buckets[hist_bucket(ns)]++;
+	hist->count++;
+	hist->total += ns;
+	if (ns > hist->max)
+		hist->max = ns;
+}
+
+uint64_t
+hist_percentile(const struct hist *hist, int percent)
+{
+	uint64_t	rank, seen = 0;
+	int		i;
+
+	rank = (hist->count * percent + 99) / 100;
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		seen += hist->buckets[i];
+		if (seen >= rank)
+			return hist_value(i);
+	}
+	return hist->max;
+}
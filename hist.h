@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HIST_H_
+#define	_HIST_H_
+
+#include <stdint.h>
+
+/*
+ * log-linear histograms of nanoseconds: HIST_SUB buckets per power of two,
+ * a bucket is at most 1/HIST_SUB of its value wide, up to 2^HIST_MAX_BITS ns
+ * (a minute).
+ */
+#define	HIST_SUB_BITS	2
+#define	HIST_SUB	(1 << HIST_SUB_BITS)
+#define	HIST_MAX_BITS	36
+#define	HIST_BUCKETS	((HIST_MAX_BITS - HIST_SUB_BITS + 2) * HIST_SUB)
+
+struct hist {
+	uint64_t	count;
+	uint64_t	total;
+	uint64_t	max;
+	uint64_t	buckets[HIST_BUCKETS];
+};
+
+void		hist_add(struct hist *, uint64_t);
+uint64_t	hist_value(int);
+uint64_t	hist_percentile(const struct hist *, int);
+
+#endif
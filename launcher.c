@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * programs are started by a small helper forked before the X connection is
+ * opened.  posix_spawn() from a process that holds neither our heap nor the
+ * X socket stays cheap, and the event loop only has to write a datagram.
+ * the launcher reaps its own children, we only have to notice it dying.
+ */
+
+#include <sys/types.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fion.h"
+#include "log.h"
+
+#define	LAUNCHER_MSG_MAX	4096
+#define	LAUNCHER_ARGV_MAX	64
+
+extern char **environ;
+
+static void	launcher_main(int fd, const sigset_t *mask);
+static void	launcher_exec(char *buf, size_t len);
+static void	launcher_drain(int sigfd);
+
+void
+launcher_init(struct wm *wm)
+{
+	sigset_t	mask;
+	int		sp[2];
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sp) == -1)
+		err(1, "socketpair");
+
+	/* SIGCHLD is already blocked, the launcher reads it from its own signalfd */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+
+	switch ((wm->launcher_pid = fork())) {
+	case -1:
+		err(1, "fork");
+	case 0:
+		close(sp[0]);
+		close(wm->signals);
+		log_procinit("launcher");
+		launcher_main(sp[1], &mask);
+		/* NOTREACHED */
+	}
+
+	close(sp[1]);
+	wm->launcher = sp[0];
+}
+
+void
+launcher_done(struct wm *wm)
+{
+	if (wm->launcher == -1)
+		return;
+
+	/* the launcher exits once its end of the socket is closed */
+	close(wm->launcher);
+	wm->launcher = -1;
+	waitpid(wm->launcher_pid, NULL, 0);
+}
+
+/* never blocks: a command that does not fit in the socket is dropped */
+void
+launcher_spawn(struct wm *wm, const char *const argv[])
+{
+	char	buf[LAUNCHER_MSG_MAX];
+	size_t	len, n;
+
+	if (wm->launcher == -1) {
+		log_warnx("launcher_spawn: no launcher, not running %s", argv[0]);
+		return;
+	}
+
+	for (len = 0; *argv; ++argv) {
+		n = strlen(*argv) + 1;
+		if (len + n > sizeof buf) {
+			log_warnx("launcher_spawn: command too long");
+			return;
+		}
+		memcpy(buf + len, *argv, n);
+		len += n;
+	}
+
+	if (send(wm->launcher, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL) == -1)
+		log_warn("launcher_spawn");
+}
+
+void
+launcher_reap(struct wm *wm)
+{
+	pid_t	pid;
+	int	status;
+
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		if (pid != wm->launcher_pid)
+			continue;
+		log_warnx("launcher exited with status %d", status);
+		close(wm->launcher);
+		wm->launcher = -1;
+	}
+}
+
+static void
+launcher_drain(int sigfd)
+{
+	struct signalfd_siginfo	si;
+
+	while (read(sigfd, &si, sizeof si) == sizeof si)
+		;
+}
+
+static void
+launcher_main(int fd, const sigset_t *mask)
+{
+	struct pollfd	pfd[2];
+	char		buf[LAUNCHER_MSG_MAX];
+	ssize_t		n;
+
+	pfd[0].fd = fd;
+	pfd[0].events = POLLIN;
+	if ((pfd[1].fd = signalfd(-1, mask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1)
+		fatal("signalfd");
+	pfd[1].events = POLLIN;
+
+	for (;;) {
+		if (poll(pfd, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			fatal("poll");
+		}
+
+		if (pfd[1].revents & POLLIN) {
+			launcher_drain(pfd[1].fd);
+			while (waitpid(-1, NULL, WNOHANG) > 0)
+				;
+		}
+
+		if (pfd[0].revents & (POLLIN | POLLHUP)) {
+			if ((n = recv(fd, buf, sizeof buf, 0)) == -1) {
+				if (errno == EINTR || errno == EAGAIN)
+					continue;
+				fatal("recv");
+			}
+			if (n == 0)
+				_exit(0);
+			launcher_exec(buf, n);
+		}
+	}
+}
+
+static void
+launcher_exec(char *buf, size_t len)
+{
+	posix_spawnattr_t	attr;
+	sigset_t		mask;
+	char		       *argv[LAUNCHER_ARGV_MAX + 1];
+	size_t			i;
+	int			argc, ret;
+	pid_t			pid;
+
+	if (len == 0 || buf[len - 1] != '\0') {
+		log_warnx("launcher: malformed command");
+		return;
+	}
+
+	argc = 0;
+	for (i = 0; i < len && argc < LAUNCHER_ARGV_MAX; i += strlen(buf + i) + 1)
+		argv[argc++] = buf + i;
+	argv[argc] = NULL;
+
+	/* children get the default signal disposition and an empty mask */
+	sigemptyset(&mask);
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGPIPE);
+	posix_spawnattr_setsigdefault(&attr, &mask);
+	posix_spawnattr_setflags(&attr,
+	    POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+	ret = posix_spawnp(&pid, argv[0], NULL, &attr, argv, environ);
+	posix_spawnattr_destroy(&attr);
+	if (ret != 0) {
+		errno = ret;
+		log_warn("launcher: %s", argv[0]);
+		return;
+	}
+	log_debug("launcher: %s started as pid %d", argv[0], (int)pid);
+}
@@ -22,11 +22,11 @@
 #include <string.h>
 #include <unistd.h>
 
-#include "fion.h"
+#include "layout.h"
 #include "log.h"
+#include "pool.h"
 
 static struct window *find_window(struct wm *wm, xcb_window_t xcb_window);
-static struct window *xfind_window(struct wm *wm, xcb_window_t xcb_window);
 static struct window *find_ancestor(struct wm *wm, struct window *node, enum window_type type);
 static struct window *find_screen(struct wm *wm, xcb_window_t xcb_root);
 static struct window *find_workarea(struct wm *wm, struct window *screen);
@@ -37,7 +37,7 @@ static struct window *find_active_tile(struct wm *wm, xcb_window_t xcb_root);
 static struct window *find_tile_next(struct wm *wm, struct window *tile);
 static struct window *find_tile_prev(struct wm *wm, struct window *tile);
 
-static struct window *create_screen(struct wm *wm, xcb_screen_t *xcb_screen);
+static struct window *create_screen(struct wm *wm, xcb_screen_t *xcb_screen, xcb_window_t xcb_root, int width, int height);
 static struct window *create_status(struct wm *wm, struct window *screen);
 static struct window *create_workarea(struct wm *wm, struct window *screen);
 static struct window *create_workspace(struct wm *wm, struct window *screen);
@@ -66,10 +66,8 @@ window_type_name(struct window *window);
 
 static uint64_t objid;
 
-/**/
-static xcb_gc_t gc_font_get (struct wm *wm, struct window *window, const char *font_name);
-static void text_draw (struct wm *wm, struct window *window, int16_t x1, int16_t y1, const char *label);
-/**/
+static struct pool window_pool =
+    POOL_INITIALIZER("window", sizeof(struct window));
 
 void
 layout_debug(struct wm *wm, struct window *window, int depth);
@@ -78,7 +76,7 @@ layout_debug(struct wm *wm, struct window *window, int depth);
 void
 layout_init(struct wm *wm)
 {
-	tree_init(&wm->windows);
+	hash_init(&wm->windows);
 	tree_init(&wm->screens_by_window);
 
 	tree_init(&wm->tiles_by_id);
@@ -89,12 +87,22 @@ layout_init(struct wm *wm)
 	tree_init(&wm->curr_workspace);
 	tree_init(&wm->curr_tile);
 	tree_init(&wm->curr_frame);
+
+	tree_init(&wm->render_by_screen);
+	tree_init(&wm->errors_by_sequence);
+
+	hash_init(&wm->intakes);
+	TAILQ_INIT(&wm->intake_queue);
+
+	TAILQ_INIT(&wm->dirty);
 }
 
 void
-layout_screen_register(struct wm *wm, xcb_screen_t *xcb_screen)
+layout_screen_register(struct wm *wm, xcb_screen_t *xcb_screen,
+    xcb_window_t xcb_root, int width, int height)
 {
-	struct window *screen = create_screen(wm, xcb_screen);
+	struct window *screen = create_screen(wm, xcb_screen, xcb_root, width,
+	    height);
 
 	if (wm->active_screen == NULL)
 		wm->active_screen = screen;
@@ -109,9 +117,8 @@ layout_screen_render(struct wm *wm)
 	iter = NULL;
 	while (tree_iter(&wm->screens_by_window, &iter, NULL, (void **)&node)) {
 		prepare_screen(wm, node);
-		window_map(wm, node);
+		scene_map(wm, node);
 	}
-	xcb_flush(wm->conn);
 }
 
 void
@@ -122,6 +129,10 @@ layout_debug(struct wm *wm, struct window *window, int depth)
 	char *buffer;
 	struct window *node;
 
+	/* the walk is only worth it when its output is logged */
+	if (log_getverbose() < 2)
+		return;
+
 	if (window == NULL) {
 		iter = NULL;
 		while (tree_iter(&wm->screens_by_window, &iter, NULL, (void **)&window))
@@ -153,10 +164,9 @@ layout_update(struct wm *wm)
 
 	iter = NULL;
 	while (tree_iter(&wm->screens_by_window, &iter, NULL, (void **)&screen)) {
-		status = tree_xget(&wm->curr_status, screen->xcb_screen->root);
+		status = tree_xget(&wm->curr_status, screen->xcb_window);
 		layout_update_status(wm, status);
 	}
-	xcb_flush(wm->conn);
 }
 
 void
@@ -180,7 +190,7 @@ layout_update_status(struct wm *wm, struct window *status)
 	    buffer,
 	    n_screen,
 	    n_workspace,
-	    find_active_tile(wm, screen->xcb_screen->root));
+	    find_active_tile(wm, screen->xcb_window));
 }
 
 static void
@@ -193,7 +203,7 @@ status_printf(struct wm *wm, struct window *status, const char *fmt, ...)
 	vasprintf(&ret, fmt, ap);
 	va_end(ap);
 
-	text_draw(wm, status, 0, 12, ret);
+	scene_text(wm, status, 0, 12, ret);
 	free(ret);
 }
 
@@ -202,26 +212,25 @@ status_printf(struct wm *wm, struct window *status, const char *fmt, ...)
 static struct window *
 find_window(struct wm *wm, xcb_window_t xcb_window)
 {
-	return tree_get(&wm->windows, xcb_window);
-}
-
-static struct window *
-xfind_window(struct wm *wm, xcb_window_t xcb_window)
-{
-	return tree_xget(&wm->windows, xcb_window);
+	return hash_get(&wm->windows, xcb_window);
 }
 
+/* screen and workspace are cached on every node, other types walk up the parent chain */
 static struct window *
 find_ancestor(struct wm *wm, struct window *node, enum window_type type)
 {
-	struct window *parent;
+	switch (type) {
+	case WT_SCREEN:
+		return node->type == WT_SCREEN ? NULL : node->screen;
+	case WT_WORKSPACE:
+		return node->type == WT_WORKSPACE ? NULL : node->workspace;
+	default:
+		break;
+	}
 
-	do {
-		parent = find_window(wm, node->xcb_parent);
-		if (parent->type == type)
-			return parent;
-		node = parent;
-	} while (node->type != WT_SCREEN);
+	for (node = node->parent; node; node = node->parent)
+		if (node->type == type)
+			return node;
 
 	return (NULL);
 }
@@ -235,13 +244,13 @@ find_screen(struct wm *wm, xcb_window_t xcb_root)
 static struct window *
 find_workarea(struct wm *wm, struct window *screen)
 {
-	return tree_xget(&wm->curr_workarea, screen->xcb_screen->root);
+	return tree_xget(&wm->curr_workarea, screen->xcb_window);
 }
 
 static struct window *
 find_workspace(struct wm *wm, struct window *screen)
 {
-	return tree_xget(&wm->curr_workspace, screen->xcb_screen->root);
+	return tree_xget(&wm->curr_workspace, screen->xcb_window);
 }
 
 static struct window *
@@ -293,77 +302,50 @@ find_active_tile(struct wm *wm, xcb_window_t xcb_root)
 static struct window *
 find_tile_next(struct wm *wm, struct window *tile)
 {
-	struct window *workspace = find_ancestor(wm, tile, WT_WORKSPACE);
 	struct window *node;
-	void *iter;
-
-	iter = NULL;
-	while (tree_iterfrom(&wm->tiles_by_id, &iter, tile->objid + 1, NULL, (void **)&node)) {
-		if (find_ancestor(wm, node, WT_WORKSPACE) == workspace)
-			return node;
-	}
-	while (tree_iter(&wm->tiles_by_id, &iter, NULL, (void **)&node))
-		if (find_ancestor(wm, node, WT_WORKSPACE) == workspace)
-			return node;
-
-	return tile;
 
+	if ((node = TAILQ_NEXT(tile, tile_entry)) == NULL)
+		node = TAILQ_FIRST(&tile->workspace->tiles);
+	return node;
 }
 
 static struct window *
 find_tile_prev(struct wm *wm, struct window *tile)
 {
-	struct window *workspace = find_ancestor(wm, tile, WT_WORKSPACE);
 	struct window *node;
-	struct window *prev;
-	struct window *last;
-	void *iter;
-
-	prev = iter = NULL;
-	while (tree_iter(&wm->tiles_by_id, &iter, NULL, (void **)&node)) {
-		if (node->objid == tile->objid) {
-			if (prev)
-				return prev;
-			break;
-		}
-		if (find_ancestor(wm, node, WT_WORKSPACE) == workspace)
-			prev = node;
-	}
 
-	iter = NULL;
-	while (tree_iter(&wm->tiles_by_id, &iter, NULL, (void **)&node))
-		if (find_ancestor(wm, node, WT_WORKSPACE) == workspace)
-			last = node;
-	if (last == NULL)
-		return tile;
-	return last;
+	if ((node = TAILQ_PREV(tile, tilelist, tile_entry)) == NULL)
+		node = TAILQ_LAST(&tile->workspace->tiles, tilelist);
+	return node;
 }
 
 
 /* high-level window creation functions */
 static struct window *
-create_screen(struct wm *wm, xcb_screen_t *xcb_screen)
+create_screen(struct wm *wm, xcb_screen_t *xcb_screen, xcb_window_t xcb_root,
+    int width, int height)
 {
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_SCREEN;
+	window->screen = window;
 	window->xcb_screen = xcb_screen;
 
-	window->xcb_window = xcb_screen->root;
+	window->xcb_window = xcb_root;
 	window->border_width = BORDER_SCREEN_WIDTH;
-	window->width = xcb_screen->width_in_pixels;
-	window->height = xcb_screen->height_in_pixels;
+	window->width = width;
+	window->height = height;
 
 	tree_xset(&wm->screens_by_window, window->xcb_window, window);
 
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_init(&window->children);
-	return window_create_screen(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 static struct window *
@@ -371,27 +353,30 @@ create_status(struct wm *wm, struct window *parent)
 {
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_STATUSBAR;
+	window->parent = parent;
+	window->screen = parent->screen;
+	window->workspace = parent->workspace;
 	window->xcb_screen = parent->xcb_screen;
 	window->xcb_parent = parent->xcb_window;
-	window->xcb_window = xcb_generate_id(wm->conn);
+	window->xcb_window = wm->generate_id(wm);
 
 	window->border_width = BORDER_STATUS_WIDTH;
 	window->x = window->y = parent->border_width;
 	window->width = parent->width - window->border_width * 2;
 	window->height = STATUS_HEIGHT;
 
-	tree_set(&wm->curr_status, parent->xcb_screen->root, window);
+	tree_set(&wm->curr_status, parent->screen->xcb_window, window);
 
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_init(&window->children);
 	tree_xset(&parent->children, window->objid, window);
-	return window_create_status(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 static struct window *
@@ -399,15 +384,17 @@ create_workarea(struct wm *wm, struct window *parent)
 {
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_WORKAREA;
+	window->parent = parent;
+	window->screen = parent->screen;
+	window->workspace = parent->workspace;
 	window->xcb_screen = parent->xcb_screen;
 	window->xcb_parent = parent->xcb_window;
-	window->xcb_window = xcb_generate_id(wm->conn);
+	window->xcb_window = wm->generate_id(wm);
 
 	window->border_width = BORDER_WORKAREA_WIDTH;
 	window->x = parent->border_width;
@@ -415,12 +402,13 @@ create_workarea(struct wm *wm, struct window *parent)
 	window->width = parent->width - window->border_width * 2;
 	window->height = parent->height - STATUS_HEIGHT - window->border_width * 2;
 
-	tree_set(&wm->curr_workarea, parent->xcb_screen->root, window);
+	tree_set(&wm->curr_workarea, parent->screen->xcb_window, window);
 
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_init(&window->children);
 	tree_xset(&parent->children, window->objid, window);
-	return window_create_workarea(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 static struct window *
@@ -428,43 +416,49 @@ create_workspace(struct wm *wm, struct window *parent)
 {
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_WORKSPACE;
+	window->parent = parent;
+	window->screen = parent->screen;
+	window->workspace = window;
 	window->xcb_screen = parent->xcb_screen;
 	window->xcb_parent = parent->xcb_window;
-	window->xcb_window = xcb_generate_id(wm->conn);
+	window->xcb_window = wm->generate_id(wm);
 
 	window->border_width = BORDER_WORKSPACE_WIDTH;
 	window->width = parent->width - window->border_width * 2;
 	window->height = parent->height - window->border_width * 2;
+	TAILQ_INIT(&window->tiles);
 
-	tree_set(&wm->curr_workspace, parent->xcb_screen->root, window);
+	tree_set(&wm->curr_workspace, parent->screen->xcb_window, window);
 
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_init(&window->children);
 	tree_xset(&parent->children, window->objid, window);
-	return window_create_workspace(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 static struct window *
 create_tile_fork(struct wm *wm, struct window *tile)
 {
-	struct window *parent = xfind_window(wm, tile->xcb_parent);
+	struct window *parent = tile->parent;
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_TILEFORK;
+	window->parent = parent;
+	window->screen = tile->screen;
+	window->workspace = tile->workspace;
 	window->xcb_screen = tile->xcb_screen;
 	window->xcb_parent = tile->xcb_parent;
-	window->xcb_window = xcb_generate_id(wm->conn);
+	window->xcb_window = wm->generate_id(wm);
 
 	window->x = tile->x;
 	window->y = tile->y;
@@ -472,12 +466,13 @@ create_tile_fork(struct wm *wm, struct window *tile)
 	window->width = tile->width + ((tile->border_width - window->border_width) * 2);
 	window->height = tile->height + ((tile->border_width - window->border_width) * 2);
 	
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_init(&window->children);
 
 	tree_xset(&parent->children, window->objid, window);
 
-	return window_create_tilefork(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 static struct window *
@@ -485,15 +480,17 @@ create_tile(struct wm *wm, struct window *parent)
 {
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_TILE;
+	window->parent = parent;
+	window->screen = parent->screen;
+	window->workspace = parent->workspace;
 	window->xcb_screen = parent->xcb_screen;
 	window->xcb_parent = parent->xcb_window;
-	window->xcb_window = xcb_generate_id(wm->conn);
+	window->xcb_window = wm->generate_id(wm);
 
 	window->border_width = BORDER_TILE_WIDTH;
 	window->width = parent->width - window->border_width * 2;
@@ -501,12 +498,14 @@ create_tile(struct wm *wm, struct window *parent)
 
 	tree_xset(&wm->tiles_by_id, window->objid, window);
 	tree_xset(&wm->tiles_by_window, window->objid, window);
+	TAILQ_INSERT_TAIL(&window->workspace->tiles, window, tile_entry);
 
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_init(&window->children);
 
 	tree_xset(&parent->children, window->objid, window);
-	return window_create_tile(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 static struct window *
@@ -514,12 +513,14 @@ create_client(struct wm *wm, struct window *parent, xcb_window_t xcb_window)
 {
 	struct window *window;
 
-	if ((window = calloc(1, sizeof(*window))) == NULL)
-		return (NULL);
+	window = pool_get(&window_pool);
 
 	window->objid = ++objid;
 
 	window->type = WT_CLIENT;
+	window->parent = parent;
+	window->screen = parent->screen;
+	window->workspace = parent->workspace;
 	window->xcb_screen = parent->xcb_screen;
 	window->xcb_parent = parent->xcb_window;
 	window->xcb_window = xcb_window;
@@ -527,9 +528,10 @@ create_client(struct wm *wm, struct window *parent, xcb_window_t xcb_window)
 	window->width = parent->width - window->border_width * 2;
 	window->height = parent->height - window->border_width * 2;
 
-	tree_xset(&wm->windows, window->xcb_window, window);
+	hash_xset(&wm->windows, window->xcb_window, window);
 	tree_xset(&parent->children, window->objid, window);
-	return window_create_client(wm, window);
+	scene_create(wm, window);
+	return window;
 }
 
 
@@ -537,12 +539,12 @@ create_client(struct wm *wm, struct window *parent, xcb_window_t xcb_window)
 void
 destroy_client(struct wm *wm, struct window *client)
 {
-	struct window *parent = find_window(wm, client->xcb_parent);
+	struct window *parent = client->parent;
 
-	window_destroy(wm, client);
-	tree_xpop(&wm->windows, client->xcb_window);
+	scene_destroy(wm, client);
+	hash_xpop(&wm->windows, client->xcb_window);
 	tree_xpop(&parent->children, client->objid);
-	free(client);
+	pool_put(&window_pool, client);
 }
 
 
@@ -553,13 +555,13 @@ prepare_screen(struct wm *wm, struct window *screen)
 	struct window *window;
 
 	window = create_status(wm, screen);
-	window_map(wm, window);
+	scene_map(wm, window);
 
 	window = create_workarea(wm, screen);
-	window_map(wm, window);
+	scene_map(wm, window);
 
 	window = create_workspace(wm, window);
-	window_map(wm, window);
+	scene_map(wm, window);
 
 	prepare_workspace(wm, window);
 }
@@ -577,8 +579,8 @@ prepare_workspace(struct wm *wm, struct window *workspace)
 	prepare_tile_fork(wm, tile, parent);
 	prepare_tile(wm, tile);
 
-	window_map(wm, tile);
-	window_map(wm, parent);
+	scene_map(wm, tile);
+	scene_map(wm, parent);
 
 	tile_set_active(wm, tile);
 }
@@ -591,14 +593,15 @@ prepare_tile(struct wm *wm, struct window *tile)
 static void
 prepare_tile_fork(struct wm *wm, struct window *tile, struct window *parent)
 {
-	struct window *old = find_window(wm, tile->xcb_parent);
+	struct window *old = tile->parent;
 
 	tile->width = parent->width - tile->border_width * 2;
 	tile->height = parent->height - tile->border_width * 2;
-	window_resize(wm, tile);
+	scene_resize(wm, tile);
 
+	tile->parent = parent;
 	tile->xcb_parent = parent->xcb_window;
-	window_reparent(wm, parent, tile);
+	scene_reparent(wm, parent, tile);
 
 	tree_xpop(&old->children, tile->objid);
 	tree_xset(&parent->children, tile->objid, tile);
@@ -616,7 +619,7 @@ screen_number(struct wm *wm, struct window *screen)
 	n = 0;
 	iter = NULL;
 	while (tree_iter(&wm->screens_by_window, &iter, NULL, (void **)&node)) {
-		if (node->xcb_screen->root == screen->xcb_screen->root)
+		if (node->xcb_window == screen->xcb_window)
 			break;
 		n++;
 	}
@@ -638,7 +641,7 @@ workspace_number(struct wm *wm, struct window *workspace)
 	while (tree_iter(&workarea->children, &iter, NULL, (void **)&node)) {
 		if (node->xcb_window == workspace->xcb_window)
 			break;
-		if (node->xcb_screen->root == workspace->xcb_screen->root)
+		if (node->screen->xcb_window == workspace->screen->xcb_window)
 			n++;
 	}
 	return n;
@@ -649,14 +652,14 @@ workspace_number(struct wm *wm, struct window *workspace)
 static void
 tile_set_active(struct wm *wm, struct window *tile)
 {
-	struct window *curr_tile = find_active_tile(wm, tile->xcb_screen->root);
+	struct window *curr_tile = find_active_tile(wm, tile->screen->xcb_window);
 	struct window *workspace = find_ancestor(wm, tile, WT_WORKSPACE);
 
 	if (tile != curr_tile)
-		window_border_color(wm, curr_tile, "#335599");
+		scene_border_color(wm, curr_tile, "#335599");
 
 	tree_set(&wm->curr_tile, workspace->xcb_window, tile);
-	window_border_color(wm, tile, "#ff0000");
+	scene_border_color(wm, tile, "#ff0000");
 }
 
 static struct window *
@@ -674,6 +677,10 @@ tile_split(struct wm *wm, struct window *tile, enum split direction)
 	sibling = create_tile(wm, parent);
 	prepare_tile(wm, sibling);
 
+	/* the new tile follows the one it was split from */
+	TAILQ_REMOVE(&tile->workspace->tiles, sibling, tile_entry);
+	TAILQ_INSERT_AFTER(&tile->workspace->tiles, tile, sibling, tile_entry);
+
 	/* 3- reparent current tile to new parent */
 	prepare_tile_fork(wm, tile, parent);
 
@@ -725,7 +732,7 @@ tile_resize(struct wm *wm, struct window *tile)
 		node->x = node->y = 0;
 		node->height = tile->height - node->border_width * 2;
 		node->width = tile->width - node->border_width * 2;
-		window_resize(wm, node);
+		scene_resize(wm, node);
 		if (node->type == WT_TILEFORK || node->type == WT_TILE || node->type == WT_FRAME)
 			tile_resize(wm, node);
 	}
@@ -742,19 +749,29 @@ layout_client_create(struct wm *wm, xcb_window_t xcb_root, xcb_window_t xcb_wind
 	client = create_client(wm, tile, xcb_window);
 	
 	if (find_window(wm, client->xcb_window) == NULL)
-		tree_xset(&wm->windows, client->xcb_window, client);
+		hash_xset(&wm->windows, client->xcb_window, client);
 
-	window_reparent(wm, tile, client);
-	window_resize(wm, client);
+	scene_reparent(wm, tile, client);
+	scene_resize(wm, client);
 
 	return (client);
 }
 
+/* clients unmap themselves behind our back, always honour their requests */
+void
+layout_client_map(struct wm *wm, struct window *client)
+{
+	client->sent.mapped = 0;
+	scene_map(wm, client);
+}
+
 void
 layout_client_destroy(struct wm *wm, xcb_window_t xcb_window)
 {
 	struct window *client = find_window(wm, xcb_window);
 
+	if (client == NULL || client->type != WT_CLIENT)
+		return;
 	destroy_client(wm, client);
 }
 
@@ -763,19 +780,19 @@ layout_client_destroy(struct wm *wm, xcb_window_t xcb_window)
 struct window *
 layout_window_get(struct wm *wm, xcb_window_t xcb_window)
 {
-	return tree_get(&wm->windows, xcb_window);
+	return hash_get(&wm->windows, xcb_window);
 }
 
 int
 layout_window_exists(struct wm *wm, xcb_window_t xcb_window)
 {
-	return tree_get(&wm->windows, xcb_window) ? 1 : 0;
+	return hash_get(&wm->windows, xcb_window) ? 1 : 0;
 }
 
 void
 layout_window_remove(struct wm *wm, xcb_window_t xcb_window)
 {
-	struct window	*window = tree_xpop(&wm->windows, xcb_window);
+	struct window	*window = hash_xpop(&wm->windows, xcb_window);
 
 	switch (window->type) {
 	case WT_CLIENT:
@@ -789,7 +806,7 @@ layout_window_remove(struct wm *wm, xcb_window_t xcb_window)
 		err(1, "can't remove this window");
 	}
 
-	free(window);
+	pool_put(&window_pool, window);
 }
 
 /* user commands */
@@ -803,9 +820,8 @@ layout_workspace_create(struct wm *wm, xcb_window_t xcb_root)
 
 	window = create_workspace(wm, workarea);
 	prepare_workspace(wm, window);
-	window_map(wm, window);
-	window_unmap(wm, workspace);
-	layout_update(wm);
+	scene_map(wm, window);
+	scene_unmap(wm, workspace);
 }
 
 void
@@ -823,10 +839,9 @@ layout_workspace_destroy(struct wm *wm, xcb_window_t xcb_root)
 		return;
 	}
 
-	window_map(wm, next);
-	tree_set(&wm->curr_workspace, screen->xcb_screen->root, next);	
-	window_unmap(wm, workspace);	
-	layout_update(wm);
+	scene_map(wm, next);
+	tree_set(&wm->curr_workspace, screen->xcb_window, next);	
+	scene_unmap(wm, workspace);	
 }
 
 void
@@ -839,10 +854,9 @@ layout_workspace_next(struct wm *wm, xcb_window_t xcb_root)
 	if (next == workspace)
 		return;
 
-	window_map(wm, next);
-	tree_set(&wm->curr_workspace, screen->xcb_screen->root, next);
-	window_unmap(wm, workspace);
-	layout_update(wm);
+	scene_map(wm, next);
+	tree_set(&wm->curr_workspace, screen->xcb_window, next);
+	scene_unmap(wm, workspace);
 }
 
 void
@@ -855,10 +869,9 @@ layout_workspace_prev(struct wm *wm, xcb_window_t xcb_root)
 	if (prev == workspace)
 		return;
 
-	window_map(wm, prev);
-	tree_set(&wm->curr_workspace, screen->xcb_screen->root, prev);
-	window_unmap(wm, workspace);
-	layout_update(wm);
+	scene_map(wm, prev);
+	tree_set(&wm->curr_workspace, screen->xcb_window, prev);
+	scene_unmap(wm, workspace);
 }
 
 void
@@ -867,26 +880,26 @@ layout_tile_split(struct wm *wm, xcb_window_t xcb_root, enum split direction)
 	struct window *tile = find_active_tile(wm, xcb_root);
 	struct window *sibling;
 
-	window_unmap(wm, tile);
+	scene_unmap(wm, tile);
 
 	sibling = tile_split(wm, tile, direction);
 
 	tile_set_active(wm, tile);
 
-	window_resize(wm, sibling);
-	window_resize(wm, tile);
+	scene_resize(wm, sibling);
+	scene_resize(wm, tile);
 
 	tile_resize(wm, sibling);
 	tile_resize(wm, tile);
 
-	window_map(wm, find_ancestor(wm, sibling, WT_TILEFORK));
-	window_map(wm, sibling);
-	window_map(wm, tile);
-	layout_update(wm);
+	scene_map(wm, find_ancestor(wm, sibling, WT_TILEFORK));
+	scene_map(wm, sibling);
+	scene_map(wm, tile);
 	/**
 	 */
 	log_debug("----------");
 	layout_debug(wm, NULL, 0);
+	pool_report();
 	log_debug("-");
 }
 
@@ -902,7 +915,6 @@ layout_tile_next(struct wm *wm, xcb_window_t xcb_root)
 
 	log_debug("next is %p", next);
 	tile_set_active(wm, next);
-	layout_update(wm);
 }
 
 void
@@ -916,7 +928,6 @@ layout_tile_prev(struct wm *wm, xcb_window_t xcb_root)
 		return;
 
 	tile_set_active(wm, prev);
-	layout_update(wm);
 }
 void
 
@@ -935,13 +946,14 @@ layout_tile_destroy(struct wm *wm, xcb_window_t xcb_root)
 		sibling->x = sibling->y = 0;
 		sibling->height = parent->height - 2*sibling->border_width;
 		sibling->width = parent->width - 2*sibling->border_width;
-		window_resize(wm, sibling);
+		scene_resize(wm, sibling);
 		tile_set_active(wm, sibling);
 
-		window_unmap(wm, tile);
+		scene_unmap(wm, tile);
 		tree_xpop(&wm->tiles_by_id, tile->objid);
+		TAILQ_REMOVE(&tile->workspace->tiles, tile, tile_entry);
 		tree_xpop(&parent->children, tile->objid);
-		tree_xpop(&wm->windows, tile->xcb_window);
+		hash_xpop(&wm->windows, tile->xcb_window);
 
 		/* tilefork collapsing required ? */
 	}
@@ -949,6 +961,7 @@ layout_tile_destroy(struct wm *wm, xcb_window_t xcb_root)
 	 */
 	log_debug("----------");
 	layout_debug(wm, NULL, 0);
+	pool_report();
 	log_debug("-");
 }
 
@@ -961,93 +974,17 @@ layout_tile_set_active(struct wm *wm, xcb_window_t window)
 }
 
 void
-layout_window_resize(struct wm *wm, xcb_window_t window)
+layout_window_configured(struct wm *wm, xcb_window_t xcb_window,
+    uint16_t sequence, int x, int y, int width, int height)
 {
-	struct window *tile = find_window(wm, window);
-	window_resize(wm, tile);
-}
+	struct window *window = find_window(wm, xcb_window);
 
-
-/**/
-static void
-text_draw(struct wm *wm, struct window *window, int16_t x1, int16_t y1, const char *label)
-{
-	xcb_void_cookie_t    cookie_gc;
-	xcb_void_cookie_t    cookie_text;
-	xcb_generic_error_t *error;
-	xcb_gcontext_t       gc;
-	uint8_t              length;
-
-	length = strlen (label);
-
-	gc = gc_font_get(wm, window, "7x13");
-
-	cookie_text = xcb_image_text_8_checked (wm->conn, length, window->xcb_window, gc,
-	    x1,
-	    y1, label);
-	error = xcb_request_check (wm->conn, cookie_text);
-	if (error) {
-		fprintf (stderr, "ERROR: can't paste text : %d\n", error->error_code);
-		xcb_disconnect (wm->conn);
-		exit (-1);
-	}
-
-	cookie_gc = xcb_free_gc (wm->conn, gc);
-	error = xcb_request_check (wm->conn, cookie_gc);
-	if (error) {
-		fprintf (stderr, "ERROR: can't free gc : %d\n", error->error_code);
-		xcb_disconnect (wm->conn);
-		exit (-1);
-	}
+	if (window == NULL)
+		return;
+	scene_configured(wm, window, sequence, x, y, width, height);
 }
 
-static xcb_gc_t
-gc_font_get (struct wm *wm, struct window *window, const char *font_name)
-{
-	uint32_t             value_list[3];
-	xcb_void_cookie_t    cookie_font;
-	xcb_void_cookie_t    cookie_gc;
-	xcb_generic_error_t *error;
-	xcb_font_t           font;
-	xcb_gcontext_t       gc;
-	uint32_t             mask;
-
-	font = xcb_generate_id (wm->conn);
-	cookie_font = xcb_open_font_checked (wm->conn, font,
-	    strlen (font_name),
-	    font_name);
-
-	error = xcb_request_check (wm->conn, cookie_font);
-	if (error) {
-		fprintf (stderr, "ERROR: can't open font : %d\n", error->error_code);
-		xcb_disconnect (wm->conn);
-		return -1;
-	}
-
-	gc = xcb_generate_id (wm->conn);
-	mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND | XCB_GC_FONT;
-	value_list[0] = window->xcb_screen->white_pixel;
-	value_list[1] = window->xcb_screen->black_pixel;
-	value_list[2] = font;
-	cookie_gc = xcb_create_gc_checked (wm->conn, gc, window->xcb_window, mask, value_list);
-	error = xcb_request_check (wm->conn, cookie_gc);
-	if (error) {
-		fprintf (stderr, "ERROR: can't create gc : %d\n", error->error_code);
-		xcb_disconnect (wm->conn);
-		exit (-1);
-	}
 
-	cookie_font = xcb_close_font_checked (wm->conn, font);
-	error = xcb_request_check (wm->conn, cookie_font);
-	if (error) {
-		fprintf (stderr, "ERROR: can't close font : %d\n", error->error_code);
-		xcb_disconnect (wm->conn);
-		exit (-1);
-	}
-
-	return gc;
-}
-/**/
 
 const char *
 window_type_name(struct window *window)
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _LAYOUT_H_
+#define	_LAYOUT_H_
+
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <stdint.h>
+#include <time.h>
+
+#include "hash.h"
+#include "trace.h"
+#include "tree.h"
+
+/*
+ * the layout library only deals in X ids, the backend's connection and
+ * screens are opaque to it and handed back in render operations.  these
+ * are the types of <xcb/xcb.h>, which backends include before this file.
+ */
+#ifndef __XCB_H__
+typedef uint32_t		xcb_window_t;
+typedef struct xcb_screen_t	xcb_screen_t;
+typedef struct xcb_connection_t	xcb_connection_t;
+#endif
+
+#define	BORDER_WIDTH			1
+#define	BORDER_SCREEN_WIDTH		0
+#define	BORDER_STATUS_WIDTH		1
+#define	BORDER_WORKAREA_WIDTH		1
+#define	BORDER_WORKSPACE_WIDTH		1
+#define	BORDER_TILEFORK_WIDTH		0
+#define	BORDER_TILE_WIDTH		1
+#define	BORDER_TILE_ACTIVE_WIDTH       	1
+
+#define	STATUS_HEIGHT	16
+
+enum split {
+	HSPLIT,
+	VSPLIT,
+};
+
+enum window_type {
+	WT_SCREEN,
+	WT_STATUSBAR,
+	WT_WORKAREA,
+	WT_WORKSPACE,
+	WT_TILEFORK,
+	WT_TILE,
+	WT_FRAME,
+	WT_CLIENT,
+};
+
+/* render operations, produced by scene_commit() and applied by a backend */
+enum op_type {
+	OP_CREATE,
+	OP_DESTROY,
+	OP_REPARENT,
+	OP_CONFIGURE,
+	OP_BORDER,
+	OP_MAP,
+	OP_UNMAP,
+	OP_TEXT,
+};
+
+/* OP_CONFIGURE fields, the bits of the ConfigureWindow value-mask */
+#define	OP_CONFIGURE_X		0x01
+#define	OP_CONFIGURE_Y		0x02
+#define	OP_CONFIGURE_WIDTH	0x04
+#define	OP_CONFIGURE_HEIGHT	0x08
+
+struct op {
+	enum op_type		type;
+	struct window	       *window;		/* NULL when it may be gone */
+	enum window_type	window_type;
+	xcb_screen_t	       *xcb_screen;
+	xcb_window_t		xcb_window;
+	xcb_window_t		xcb_parent;
+	int			x;
+	int			y;
+	int			width;
+	int			height;
+	int			border_width;
+	uint32_t		mask;
+	uint32_t		pixel;
+	char		       *text;
+	uint8_t			cause;		/* enum trace_op, for accounting */
+};
+
+struct wm {
+	xcb_connection_t *conn;
+
+	/* identifiers for the windows created by the layout */
+	xcb_window_t	(*generate_id)(struct wm *);
+
+	struct hash windows;
+
+	struct tree screens_by_id;
+	struct tree screens_by_window;
+
+	struct tree tiles_by_id;
+	struct tree tiles_by_window;
+
+	struct tree curr_workarea;
+	struct tree curr_status;
+	struct tree curr_workspace;
+	struct tree curr_tile;
+	struct tree curr_frame;
+
+	struct tree render_by_screen;
+
+	struct tree errors_by_sequence;
+
+	TAILQ_HEAD(, window) dirty;
+	struct op	*ops;
+	size_t		 nops;
+	size_t		 opsize;
+
+	struct hash intakes;
+	TAILQ_HEAD(, intake) intake_queue;
+
+	struct window *active_screen;
+
+	int		launcher;
+	pid_t		launcher_pid;
+	int		signals;
+
+	int		startup_timing;
+	struct timespec	startup;
+	uint64_t	roundtrips;
+};
+
+struct window {
+	uint64_t		winid;
+	uint64_t		objid;
+
+	enum window_type        type;
+
+    int	x;
+    int	y;
+    int	width;
+    int	height;
+	int	border_width;
+
+	struct tree		children;
+
+	struct window	       *parent;
+	struct window	       *screen;
+	struct window	       *workspace;
+
+	/* workspace: tiles in spatial order, tile: position within it */
+	TAILQ_HEAD(tilelist, window) tiles;
+	TAILQ_ENTRY(window)	tile_entry;
+
+        xcb_screen_t           *xcb_screen;
+        xcb_window_t            xcb_parent;
+        xcb_window_t            xcb_window;
+
+	uint32_t		border_pixel;
+	int			mapped;
+
+	/* last state sent to the X server, see scene_commit() */
+	struct {
+		int		x;
+		int		y;
+		int		width;
+		int		height;
+		uint32_t	border_pixel;
+		int		mapped;
+		xcb_window_t	xcb_parent;
+		uint16_t	sequence;	/* of the last ConfigureWindow */
+		char	       *text;		/* last drawn by scene_text() */
+	} sent;
+
+	int			dirty;
+	TAILQ_ENTRY(window)	dirty_entry;
+	uint8_t			cause;		/* enum trace_op that last changed it */
+
+	struct intake	       *intake;
+};
+
+
+/* layout.c */
+void		 layout_init(struct wm *wm);
+struct window	*layout_window_get(struct wm *wm, xcb_window_t xcb_window);
+struct window	*layout_frame_get_current(struct wm *wm);
+int		 layout_window_exists(struct wm *wm, xcb_window_t xcb_window);
+struct window	*layout_client_create(struct wm *wm, xcb_window_t xcb_root, xcb_window_t xcb_window);
+void		 layout_client_map(struct wm *wm, struct window *client);
+void		 layout_window_remove(struct wm *wm, xcb_window_t xcb_window);
+
+void		 layout_workspace_create(struct wm *wm, xcb_window_t xcb_root);
+void		 layout_workspace_next(struct wm *wm, xcb_window_t xcb_root);
+void		 layout_workspace_prev(struct wm *wm, xcb_window_t xcb_root);
+void		 layout_workspace_destroy(struct wm *wm, xcb_window_t xcb_root);
+
+void		 layout_screen_register(struct wm *wm, xcb_screen_t *xcb_screen, xcb_window_t xcb_root, int width, int height);
+void		 layout_screen_render(struct wm *wm);
+
+void		 layout_tile_prev(struct wm *wm, xcb_window_t xcb_root);
+void		 layout_tile_next(struct wm *wm, xcb_window_t xcb_root);
+void		 layout_tile_destroy(struct wm *wm, xcb_window_t xcb_root);
+
+void		 layout_frame_prev(struct wm *wm, xcb_window_t xcb_root);
+void		 layout_frame_next(struct wm *wm, xcb_window_t xcb_root);
+
+void		 layout_tile_split(struct wm *wm, xcb_window_t xcb_root, enum split direction);
+void		 layout_client_resize(struct wm *wm, struct window *client);
+void		 layout_update(struct wm *wm);
+void		 layout_update_status(struct wm *wm, struct window *status);
+void		 layout_tile_set_active(struct wm *wm, xcb_window_t window);
+void		 layout_client_destroy(struct wm *wm, xcb_window_t xcb_window);
+void		 layout_window_configured(struct wm *wm, xcb_window_t xcb_window, uint16_t sequence, int x, int y, int width, int height);
+
+
+/* scene.c */
+void		 scene_create(struct wm *wm, struct window *window);
+void		 scene_destroy(struct wm *wm, struct window *window);
+void		 scene_map(struct wm *wm, struct window *window);
+void		 scene_unmap(struct wm *wm, struct window *window);
+void		 scene_reparent(struct wm *wm, struct window *parent, struct window *window);
+void		 scene_resize(struct wm *wm, struct window *window);
+void		 scene_border_color(struct wm *wm, struct window *window, const char *rgb);
+void		 scene_configured(struct wm *wm, struct window *window, uint16_t sequence, int x, int y, int width, int height);
+void		 scene_text(struct wm *wm, struct window *window, int16_t x, int16_t y, const char *text);
+void		 scene_expose(struct wm *wm, struct window *window);
+void		 scene_commit(struct wm *wm);
+void		 scene_clear(struct wm *wm);
+
+#endif
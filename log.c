@@ -16,6 +16,9 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -23,12 +26,45 @@
 #include <syslog.h>
 #include <errno.h>
 #include <time.h>
+#include <unistd.h>
+
+#define	LOG_RING_SLOTS	1024	/* power of two */
+#define	LOG_RING_MSGLEN	256
 
 static int	 debug;
 static int	 verbose;
 const char	*log_procname;
 
+/*
+ * once log_async_start() is called, messages are formatted into a ring
+ * that a writer thread drains to stderr or syslog: the event loop never
+ * waits on a slow terminal.  there is a single producer and a single
+ * consumer, when the ring is full messages are counted and dropped.
+ */
+static struct {
+	struct {
+		int	pri;
+		char	msg[LOG_RING_MSGLEN];
+	}		slots[LOG_RING_SLOTS];
+
+	atomic_size_t	head;		/* next slot filled by the producer */
+	atomic_size_t	tail;		/* next slot drained by the writer */
+	atomic_size_t	dropped;
+	atomic_int	sleeping;
+	atomic_int	running;
+
+	int		doorbell[2];
+	pthread_t	writer;
+} ring;
+
+static void	 log_write(int, const char *);
+static void	 log_enqueue(int, const char *, va_list)
+	    __attribute__((__format__ (printf, 2, 0)));
+static void	*log_writer(void *);
+
 void	log_init(int, int);
+void	log_async_start(void);
+void	log_async_stop(void);
 void	log_procinit(const char *);
 void	log_setverbose(int);
 int	log_getverbose(void);
@@ -64,6 +100,118 @@ log_init(int n_debug, int facility)
 	tzset();
 }
 
+void
+log_async_start(void)
+{
+	int	i;
+
+	if (atomic_load(&ring.running))
+		return;
+
+	if (pipe(ring.doorbell) == -1) {
+		log_warn("log_async_start: pipe");
+		return;
+	}
+	for (i = 0; i < 2; ++i)
+		fcntl(ring.doorbell[i], F_SETFD, FD_CLOEXEC);
+	fcntl(ring.doorbell[1], F_SETFL, O_NONBLOCK);
+
+	atomic_store(&ring.running, 1);
+	if ((errno = pthread_create(&ring.writer, NULL, log_writer, NULL)) != 0) {
+		atomic_store(&ring.running, 0);
+		close(ring.doorbell[0]);
+		close(ring.doorbell[1]);
+		log_warn("log_async_start: pthread_create");
+		return;
+	}
+
+	/* whatever the exit path, pending messages are written out */
+	atexit(log_async_stop);
+}
+
+void
+log_async_stop(void)
+{
+	if (!atomic_exchange(&ring.running, 0))
+		return;
+
+	(void)write(ring.doorbell[1], "", 1);
+	pthread_join(ring.writer, NULL);
+	close(ring.doorbell[0]);
+	close(ring.doorbell[1]);
+}
+
+static void
+log_enqueue(int pri, const char *fmt, va_list ap)
+{
+	size_t	head, tail;
+	int	idx;
+
+	head = atomic_load_explicit(&ring.head, memory_order_relaxed);
+	tail = atomic_load_explicit(&ring.tail, memory_order_acquire);
+	if (head - tail == LOG_RING_SLOTS) {
+		atomic_fetch_add_explicit(&ring.dropped, 1, memory_order_relaxed);
+		return;
+	}
+
+	idx = head & (LOG_RING_SLOTS - 1);
+	ring.slots[idx].pri = pri;
+	(void)vsnprintf(ring.slots[idx].msg, sizeof ring.slots[idx].msg, fmt, ap);
+	atomic_store(&ring.head, head + 1);
+
+	/* only wake the writer up when it went to sleep */
+	if (atomic_exchange(&ring.sleeping, 0))
+		(void)write(ring.doorbell[1], "", 1);
+}
+
+static void *
+log_writer(void *arg)
+{
+	char	buf[64];
+	size_t	tail, dropped, reported = 0;
+	int	idx;
+
+	tail = atomic_load(&ring.tail);
+	for (;;) {
+		while (tail != atomic_load_explicit(&ring.head, memory_order_acquire)) {
+			idx = tail & (LOG_RING_SLOTS - 1);
+			log_write(ring.slots[idx].pri, ring.slots[idx].msg);
+			atomic_store_explicit(&ring.tail, ++tail, memory_order_release);
+		}
+
+		dropped = atomic_load_explicit(&ring.dropped, memory_order_relaxed);
+		if (dropped != reported) {
+			(void)snprintf(buf, sizeof buf, "log: %zu messages dropped",
+			    dropped - reported);
+			log_write(LOG_WARNING, buf);
+			reported = dropped;
+		}
+
+		if (!atomic_load(&ring.running))
+			break;
+
+		/* announce we sleep, then look again to not miss a message */
+		atomic_store(&ring.sleeping, 1);
+		if (tail != atomic_load(&ring.head)) {
+			atomic_store(&ring.sleeping, 0);
+			continue;
+		}
+		while (read(ring.doorbell[0], buf, sizeof buf) == -1 && errno == EINTR)
+			;
+	}
+	return NULL;
+}
+
+static void
+log_write(int pri, const char *msg)
+{
+	if (debug) {
+		fprintf(stderr, "%s\n", msg);
+		fflush(stderr);
+	} else
+		syslog(pri, "%s", msg);
+}
+
 void
 log_procinit(const char *procname)
 {
@@ -99,6 +247,12 @@ vlog(int pri, const char *fmt, va_list ap)
 	char	*nfmt;
 	int	 saved_errno = errno;
 
+	if (atomic_load_explicit(&ring.running, memory_order_relaxed)) {
+		log_enqueue(pri, fmt, ap);
+		errno = saved_errno;
+		return;
+	}
+
 	if (debug) {
 		/* best effort in out of mem situations */
 		if (asprintf(&nfmt, "%s\n", fmt) == -1) {
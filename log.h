@@ -22,7 +22,17 @@
 #include <stdarg.h>
 #include <sys/cdefs.h>
 
+/*
+ * messages above LOG_LEVEL are compiled out, release builds use
+ * -DLOG_LEVEL=6 to drop log_debug() calls and their arguments.
+ */
+#ifndef LOG_LEVEL
+#define	LOG_LEVEL	7	/* LOG_DEBUG */
+#endif
+
 void	log_init(int, int);
+void	log_async_start(void);
+void	log_async_stop(void);
 void	log_procinit(const char *);
 void	log_setverbose(int);
 int	log_getverbose(void);
@@ -43,4 +53,8 @@ void	vlog(int, const char *, va_list)
 /*__dead*/ void fatalx(const char *, ...)
 	    __attribute__((__format__ (printf, 1, 2)));
 
+#if LOG_LEVEL < 7
+#define	log_debug(...)	do { if (0) log_debug(__VA_ARGS__); } while (0)
+#endif
+
 #endif /* LOG_H */
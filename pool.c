@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * fixed size object pools.
+ *
+ * objects are carved out of slabs so that objects allocated together sit
+ * next to each other in memory, released objects go to a free list and
+ * slabs are never given back to the system.
+ */
+
+#include <sys/types.h>
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "pool.h"
+
+#define	POOL_SLABSIZE	16384
+
+static struct pool	*pools;
+
+static void pool_grow(struct pool *);
+
+static void
+pool_grow(struct pool *p)
+{
+	char	*slab;
+	size_t	 size, count, i;
+
+	if (p->slabs == 0) {
+		/* round objects up so that every one of them is aligned */
+		size = p->size < sizeof(void *) ? sizeof(void *) : p->size;
+		p->size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+		p->next = pools;
+		pools = p;
+	}
+
+	count = POOL_SLABSIZE / p->size;
+	if (count == 0)
+		count = 1;
+
+	if ((slab = malloc(count * p->size)) == NULL)
+		err(1, "pool_grow: malloc");
+
+	/* thread the free list in address order */
+	for (i = count; i > 0; --i) {
+		*(void **)(slab + (i - 1) * p->size) = p->freelist;
+		p->freelist = slab + (i - 1) * p->size;
+	}
+
+	p->total += count;
+	p->slabs += 1;
+}
+
+void *
+pool_get(struct pool *p)
+{
+	void	*obj;
+
+	if (p->freelist == NULL)
+		pool_grow(p);
+
+	obj = p->freelist;
+	p->freelist = *(void **)obj;
+	p->inuse += 1;
+
+	memset(obj, 0, p->size);
+	return (obj);
+}
+
+void
+pool_put(struct pool *p, void *obj)
+{
+	if (obj == NULL)
+		return;
+
+	*(void **)obj = p->freelist;
+	p->freelist = obj;
+	p->inuse -= 1;
+}
+
+void
+pool_report(void)
+{
+	struct pool	*p;
+
+	if (log_getverbose() < 2)
+		return;
+	for (p = pools; p; p = p->next)
+		log_debug("pool %s: %zu/%zu objects in use, %zu bytes in %zu slabs",
+		    p->name, p->inuse, p->total, p->inuse * p->size, p->slabs);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _POOL_H_
+#define	_POOL_H_
+
+#include <stddef.h>
+
+struct pool {
+	const char	*name;
+	size_t		 size;
+	void		*freelist;
+
+	size_t		 inuse;
+	size_t		 total;
+	size_t		 slabs;
+
+	struct pool	*next;
+};
+
+#define	POOL_INITIALIZER(n, s) { .name = (n), .size = (s) }
+
+#define pool_init(p, n, s) do { *(p) = (struct pool)POOL_INITIALIZER(n, s); } while(0)
+void *pool_get(struct pool *);
+void pool_put(struct pool *, void *);
+void pool_report(void);
+
+#endif
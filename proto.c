@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <xcb/xcb.h>
+
+#include "proto.h"
+
+/* the X names of events and requests, for fion's reports and fion-trace */
+static const char *event_names[] = {
+	"Error", "Reply", "KeyPress", "KeyRelease", "ButtonPress",
+	"ButtonRelease", "MotionNotify", "EnterNotify", "LeaveNotify",
+	"FocusIn", "FocusOut", "KeymapNotify", "Expose", "GraphicsExpose",
+	"NoExpose", "VisibilityNotify", "CreateNotify", "DestroyNotify",
+	"UnmapNotify", "MapNotify", "MapRequest", "ReparentNotify",
+	"ConfigureNotify", "ConfigureRequest", "GravityNotify",
+	"ResizeRequest", "CirculateNotify", "CirculateRequest",
+	"PropertyNotify", "SelectionClear", "SelectionRequest",
+	"SelectionNotify", "ColormapNotify", "ClientMessage",
+	"MappingNotify", "GenericEvent",
+};
+
+const char *
+proto_event_name(uint8_t type)
+{
+	if (type < sizeof event_names / sizeof event_names[0])
+		return event_names[type];
+	return "Event";
+}
+
+/* only the requests fion sends are named */
+const char *
+proto_request_name(uint8_t opcode)
+{
+	switch (opcode) {
+	case XCB_CREATE_WINDOW:			return "CreateWindow";
+	case XCB_CHANGE_WINDOW_ATTRIBUTES:	return "ChangeWindowAttributes";
+	case XCB_GET_WINDOW_ATTRIBUTES:		return "GetWindowAttributes";
+	case XCB_DESTROY_WINDOW:		return "DestroyWindow";
+	case XCB_REPARENT_WINDOW:		return "ReparentWindow";
+	case XCB_MAP_WINDOW:			return "MapWindow";
+	case XCB_UNMAP_WINDOW:			return "UnmapWindow";
+	case XCB_CONFIGURE_WINDOW:		return "ConfigureWindow";
+	case XCB_GET_GEOMETRY:			return "GetGeometry";
+	case XCB_CHANGE_SAVE_SET:		return "ChangeSaveSet";
+	case XCB_QUERY_TREE:			return "QueryTree";
+	case XCB_INTERN_ATOM:			return "InternAtom";
+	case XCB_GET_PROPERTY:			return "GetProperty";
+	case XCB_SEND_EVENT:			return "SendEvent";
+	case XCB_GRAB_KEYBOARD:			return "GrabKeyboard";
+	case XCB_UNGRAB_KEYBOARD:		return "UngrabKeyboard";
+	case XCB_GRAB_KEY:			return "GrabKey";
+	case XCB_UNGRAB_KEY:			return "UngrabKey";
+	case XCB_GET_INPUT_FOCUS:		return "GetInputFocus";
+	case XCB_OPEN_FONT:			return "OpenFont";
+	case XCB_CLOSE_FONT:			return "CloseFont";
+	case XCB_CREATE_GC:			return "CreateGC";
+	case XCB_FREE_GC:			return "FreeGC";
+	case XCB_IMAGE_TEXT_8:			return "ImageText8";
+	case XCB_NO_OPERATION:			return "NoOperation";
+	case XCB_GET_KEYBOARD_MAPPING:		return "GetKeyboardMapping";
+	}
+	return "Request";
+}
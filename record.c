@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * a recording is what is needed to bring up a stub X server looking like
+ * the recorded one, followed by the raw events read by the event loop and
+ * markers telling where the loop placed clients and committed the layout.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fion.h"
+#include "log.h"
+
+static FILE	*record_fp;
+
+void
+record_open(struct wm *wm, const char *path)
+{
+	const xcb_setup_t			*setup = xcb_get_setup(wm->conn);
+	xcb_screen_iterator_t			 iter;
+	xcb_get_keyboard_mapping_cookie_t	 cookie;
+	xcb_get_keyboard_mapping_reply_t	*mapping;
+	struct record_header			 header;
+	uint8_t					 count;
+	int					 n;
+
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, RECORD_MAGIC, sizeof header.magic);
+	header.resource_id_base = setup->resource_id_base;
+	header.resource_id_mask = setup->resource_id_mask;
+	header.min_keycode = setup->min_keycode;
+	header.max_keycode = setup->max_keycode;
+
+	iter = xcb_setup_roots_iterator(setup);
+	for (; iter.rem && header.nscreens < RECORD_SCREENS_MAX; xcb_screen_next(&iter)) {
+		header.screens[header.nscreens].root = iter.data->root;
+		header.screens[header.nscreens].root_visual = iter.data->root_visual;
+		header.screens[header.nscreens].width = iter.data->width_in_pixels;
+		header.screens[header.nscreens].height = iter.data->height_in_pixels;
+		header.screens[header.nscreens].root_depth = iter.data->root_depth;
+		header.nscreens++;
+	}
+
+	/* the stub serves the same keyboard so that key bindings replay */
+	count = setup->max_keycode - setup->min_keycode + 1;
+	cookie = xcb_get_keyboard_mapping(wm->conn, setup->min_keycode, count);
+	account_request(trace_current, XCB_GET_KEYBOARD_MAPPING,
+	    sizeof(xcb_get_keyboard_mapping_request_t), 0, cookie.sequence);
+	account_roundtrip(wm);
+	mapping = xcb_get_keyboard_mapping_reply(wm->conn, cookie, NULL);
+	if (mapping == NULL)
+		errx(1, "record_open: could not get keyboard mapping");
+	header.keysyms_per_keycode = mapping->keysyms_per_keycode;
+	n = xcb_get_keyboard_mapping_keysyms_length(mapping);
+
+	if ((record_fp = fopen(path, "w")) == NULL)
+		err(1, "record_open: %s", path);
+	if (fwrite(&header, sizeof header, 1, record_fp) != 1 ||
+	    fwrite(xcb_get_keyboard_mapping_keysyms(mapping),
+		sizeof(xcb_keysym_t), n, record_fp) != (size_t)n)
+		err(1, "record_open: %s", path);
+	free(mapping);
+
+	log_info("recording events to %s", path);
+}
+
+void
+record_close(void)
+{
+	if (record_fp == NULL)
+		return;
+	if (fclose(record_fp) == EOF)
+		log_warn("record_close");
+	record_fp = NULL;
+}
+
+void
+record_event(const xcb_generic_event_t *e)
+{
+	if (record_fp == NULL)
+		return;
+	if (fwrite(e, sizeof *e, 1, record_fp) != 1) {
+		log_warn("record_event");
+		record_close();
+	}
+}
+
+void
+record_mark(struct wm *wm, uint8_t mark)
+{
+	xcb_generic_event_t	e;
+
+	if (record_fp == NULL)
+		return;
+	memset(&e, 0, sizeof e);
+	e.response_type = RECORD_MARK;
+	e.pad0 = mark;
+	e.full_sequence = record_sequence(wm);
+	record_event(&e);
+}
+
+/* where the request stream stands, markers of older recordings have none */
+unsigned int
+record_sequence(struct wm *wm)
+{
+	xcb_void_cookie_t cookie;
+
+	cookie = xcb_no_operation(wm->conn);
+	account_request(trace_current, XCB_NO_OPERATION,
+	    sizeof(xcb_no_operation_request_t), 0, cookie.sequence);
+	return cookie.sequence;
+}
+
+int
+record_load(const char *path, struct replay *replay)
+{
+	const struct record_header     *header;
+	struct stat			sb;
+	size_t				keysyms;
+	void			       *p;
+	int				fd;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1) {
+		log_warn("record_load: %s", path);
+		return -1;
+	}
+	if (fstat(fd, &sb) == -1 || (size_t)sb.st_size < sizeof *header) {
+		log_warnx("record_load: %s: truncated recording", path);
+		close(fd);
+		return -1;
+	}
+	p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		log_warn("record_load: mmap");
+		return -1;
+	}
+
+	header = p;
+	keysyms = (size_t)(header->max_keycode - header->min_keycode + 1) *
+	    header->keysyms_per_keycode;
+	if (memcmp(header->magic, RECORD_MAGIC, sizeof header->magic) != 0 ||
+	    header->nscreens == 0 || header->nscreens > RECORD_SCREENS_MAX ||
+	    header->min_keycode > header->max_keycode ||
+	    sizeof *header + keysyms * sizeof(xcb_keysym_t) > (size_t)sb.st_size) {
+		log_warnx("record_load: %s: not a fion recording", path);
+		munmap(p, sb.st_size);
+		return -1;
+	}
+
+	replay->header = header;
+	replay->keysyms = (const xcb_keysym_t *)(header + 1);
+	replay->events = (const xcb_generic_event_t *)(replay->keysyms + keysyms);
+	replay->nevents = (sb.st_size - sizeof *header - keysyms * sizeof(xcb_keysym_t)) /
+	    sizeof(xcb_generic_event_t);
+	return 0;
+}
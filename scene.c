@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * the layout only describes what windows should look like: scene functions
+ * record that desired state and scene_commit() turns its difference with
+ * what was last rendered into a list of render operations.  applying them
+ * is left to a backend, window.c is the one talking to the X server.
+ */
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "layout.h"
+#include "log.h"
+
+static uint32_t
+rgb_pixel(const char *rgb)
+{
+        char buf[3] = { 0, 0, 0 };
+        uint32_t r, g, b;
+
+        r = strtol(memcpy(buf, rgb+1, 2), NULL, 16);
+        g = strtol(memcpy(buf, rgb+3, 2), NULL, 16);
+        b = strtol(memcpy(buf, rgb+5, 2), NULL, 16);
+
+        return ((r << 16) + (g << 8) + b);
+
+}
+
+static struct op *
+scene_op(struct wm *wm, enum op_type type, struct window *window)
+{
+	struct op *op;
+	size_t size;
+
+	if (wm->nops == wm->opsize) {
+		size = wm->opsize ? wm->opsize * 2 : 64;
+		if ((op = reallocarray(wm->ops, size, sizeof(*op))) == NULL)
+			err(1, "scene_op: reallocarray");
+		wm->ops = op;
+		wm->opsize = size;
+	}
+
+	op = &wm->ops[wm->nops++];
+	memset(op, 0, sizeof(*op));
+	op->type = type;
+	op->cause = window->cause;
+	op->window = window;
+	op->xcb_screen = window->xcb_screen;
+	op->xcb_window = window->xcb_window;
+	op->xcb_parent = window->xcb_parent;
+	return op;
+}
+
+static void
+scene_dirty(struct wm *wm, struct window *window)
+{
+	window->cause = trace_current;
+	if (window->dirty)
+		return;
+	window->dirty = 1;
+	TAILQ_INSERT_TAIL(&wm->dirty, window, dirty_entry);
+}
+
+/* record the state a window is created with as the state known to X */
+void
+scene_create(struct wm *wm, struct window *window)
+{
+	struct op *op;
+
+	window->cause = trace_current;
+	switch (window->type) {
+	case WT_STATUSBAR:
+	case WT_WORKAREA:
+		window->border_pixel = rgb_pixel("#0000ff");
+		break;
+	case WT_SCREEN:
+	case WT_CLIENT:
+		window->border_pixel = 0;
+		break;
+	default:
+		window->border_pixel = rgb_pixel("#335599");
+		break;
+	}
+
+	window->sent.x = window->x;
+	window->sent.y = window->y;
+	window->sent.width = window->width;
+	window->sent.height = window->height;
+	window->sent.border_pixel = window->border_pixel;
+	window->sent.mapped = window->mapped = 0;
+	window->sent.xcb_parent = window->xcb_parent;
+	window->sent.sequence = 0;
+	window->sent.text = NULL;
+
+	switch (window->type) {
+	case WT_SCREEN:
+		/* the root window */
+		break;
+
+	case WT_CLIENT:
+		/*
+		 * client windows already exist, they are created by their
+		 * owner and live under the root until we first reparent them.
+		 */
+		window->sent.xcb_parent = window->screen->xcb_window;
+		window->sent.x = window->sent.y = -1;
+		window->sent.width = window->sent.height = -1;
+		break;
+
+	default:
+		op = scene_op(wm, OP_CREATE, window);
+		op->window_type = window->type;
+		op->x = window->x;
+		op->y = window->y;
+		op->width = window->width;
+		op->height = window->height;
+		op->border_width = window->border_width;
+		op->pixel = window->border_pixel;
+		break;
+	}
+}
+
+void
+scene_destroy(struct wm *wm, struct window *window)
+{
+	struct op *op;
+
+	if (window->dirty) {
+		TAILQ_REMOVE(&wm->dirty, window, dirty_entry);
+		window->dirty = 0;
+	}
+	free(window->sent.text);
+	window->sent.text = NULL;
+
+	/* clients are destroyed by their owner */
+	if (window->type == WT_CLIENT || window->type == WT_SCREEN)
+		return;
+	window->cause = trace_current;
+	op = scene_op(wm, OP_DESTROY, window);
+	op->window = NULL;
+}
+
+void
+scene_map(struct wm *wm, struct window *window)
+{
+	window->mapped = 1;
+	scene_dirty(wm, window);
+}
+
+void
+scene_unmap(struct wm *wm, struct window *window)
+{
+	window->mapped = 0;
+	scene_dirty(wm, window);
+}
+
+void
+scene_reparent(struct wm *wm, struct window *parent, struct window *window)
+{
+	window->xcb_parent = parent->xcb_window;
+	scene_dirty(wm, window);
+}
+
+void
+scene_resize(struct wm *wm, struct window *window)
+{
+	scene_dirty(wm, window);
+}
+
+void
+scene_border_color(struct wm *wm, struct window *window, const char *rgb_color)
+{
+	window->border_pixel = rgb_pixel(rgb_color);
+	scene_dirty(wm, window);
+}
+
+/*
+ * notifies caused by our own requests are not older than the last one we
+ * sent, anything newer means the window was moved behind our back: record
+ * where it is so that the next commit puts it back.
+ */
+void
+scene_configured(struct wm *wm, struct window *window, uint16_t sequence,
+    int x, int y, int width, int height)
+{
+	if ((int16_t)(sequence - window->sent.sequence) <= 0)
+		return;
+
+	window->sent.x = x;
+	window->sent.y = y;
+	window->sent.width = width;
+	window->sent.height = height;
+	scene_dirty(wm, window);
+}
+
+/* text is only drawn when it differs from what the window shows */
+void
+scene_text(struct wm *wm, struct window *window, int16_t x, int16_t y, const char *text)
+{
+	struct op *op;
+
+	if (window->sent.text && strcmp(window->sent.text, text) == 0)
+		return;
+	free(window->sent.text);
+	if ((window->sent.text = strdup(text)) == NULL)
+		err(1, "scene_text: strdup");
+
+	window->cause = trace_current;
+	op = scene_op(wm, OP_TEXT, window);
+	op->window = NULL;
+	op->x = x;
+	op->y = y;
+	if ((op->text = strdup(text)) == NULL)
+		err(1, "scene_text: strdup");
+}
+
+/* the window lost its content, its text is drawn again by the next call */
+void
+scene_expose(struct wm *wm, struct window *window)
+{
+	free(window->sent.text);
+	window->sent.text = NULL;
+}
+
+/* turn the windows changed since the last commit into render operations */
+void
+scene_commit(struct wm *wm)
+{
+	struct window  *window;
+	struct op      *op;
+
+	while ((window = TAILQ_FIRST(&wm->dirty)) != NULL) {
+		TAILQ_REMOVE(&wm->dirty, window, dirty_entry);
+		window->dirty = 0;
+
+		if (window->sent.xcb_parent != window->xcb_parent) {
+			op = scene_op(wm, OP_REPARENT, window);
+			op->x = window->x;
+			op->y = window->y;
+			window->sent.xcb_parent = window->xcb_parent;
+			window->sent.x = window->x;
+			window->sent.y = window->y;
+		}
+
+		op = NULL;
+		if (window->sent.x != window->x) {
+			op = op ? op : scene_op(wm, OP_CONFIGURE, window);
+			op->mask |= OP_CONFIGURE_X;
+			op->x = window->sent.x = window->x;
+		}
+		if (window->sent.y != window->y) {
+			op = op ? op : scene_op(wm, OP_CONFIGURE, window);
+			op->mask |= OP_CONFIGURE_Y;
+			op->y = window->sent.y = window->y;
+		}
+		if (window->sent.width != window->width) {
+			op = op ? op : scene_op(wm, OP_CONFIGURE, window);
+			op->mask |= OP_CONFIGURE_WIDTH;
+			op->width = window->sent.width = window->width;
+		}
+		if (window->sent.height != window->height) {
+			op = op ? op : scene_op(wm, OP_CONFIGURE, window);
+			op->mask |= OP_CONFIGURE_HEIGHT;
+			op->height = window->sent.height = window->height;
+		}
+
+		if (window->sent.border_pixel != window->border_pixel) {
+			op = scene_op(wm, OP_BORDER, window);
+			op->pixel = window->sent.border_pixel = window->border_pixel;
+		}
+
+		if (window->sent.mapped != window->mapped) {
+			window->sent.mapped = window->mapped;
+			scene_op(wm, window->mapped ? OP_MAP : OP_UNMAP, window);
+		}
+	}
+}
+
+/* called by backends once the operations have been applied */
+void
+scene_clear(struct wm *wm)
+{
+	size_t i;
+
+	for (i = 0; i < wm->nops; ++i)
+		free(wm->ops[i].text);
+	wm->nops = 0;
+}
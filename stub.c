@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * stub X server used by replays: it runs in a thread at the other end of
+ * a socketpair, presents the screens and keyboard of the recording, swallows
+ * every request and answers the ones fion waits on with empty replies.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fion.h"
+#include "log.h"
+
+#define	STUB_REQUEST_MAX	(1 << 18)
+#define	STUB_VENDOR		"fion"
+
+struct stub {
+	int			fd;
+	const struct replay    *replay;
+	uint16_t		sequence;
+	xcb_atom_t		atoms;
+	uint8_t			request[STUB_REQUEST_MAX];
+};
+
+static void	*stub_main(void *);
+static int	 stub_setup(struct stub *);
+static int	 stub_reply(struct stub *, uint8_t);
+static int	 stub_read(int, void *, size_t);
+static int	 stub_write(int, const void *, size_t);
+
+xcb_connection_t *
+stub_connect(const struct replay *replay)
+{
+	xcb_connection_t       *conn;
+	struct stub	       *stub;
+	pthread_t		thread;
+	int			sp[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sp) == -1)
+		err(1, "stub_connect: socketpair");
+	if ((stub = calloc(1, sizeof *stub)) == NULL)
+		err(1, "stub_connect: calloc");
+	stub->fd = sp[1];
+	stub->replay = replay;
+	stub->atoms = 1000;
+
+	if ((errno = pthread_create(&thread, NULL, stub_main, stub)) != 0)
+		err(1, "stub_connect: pthread_create");
+	pthread_detach(thread);
+
+	conn = xcb_connect_to_fd(sp[0], NULL);
+	if (xcb_connection_has_error(conn))
+		errx(1, "stub_connect: xcb_connect_to_fd");
+	return conn;
+}
+
+static void *
+stub_main(void *arg)
+{
+	struct stub    *stub = arg;
+	uint16_t	length;
+
+	if (stub_setup(stub) == -1)
+		goto done;
+
+	for (;;) {
+		if (stub_read(stub->fd, stub->request, 4) == -1)
+			break;
+		memcpy(&length, stub->request + 2, sizeof length);
+		if (length == 0 || length * 4 > STUB_REQUEST_MAX) {
+			log_warnx("stub: unsupported request length");
+			break;
+		}
+		if (stub_read(stub->fd, stub->request + 4, length * 4 - 4) == -1)
+			break;
+
+		stub->sequence++;
+		if (stub_reply(stub, stub->request[0]) == -1)
+			break;
+	}
+
+done:
+	close(stub->fd);
+	free(stub);
+	return NULL;
+}
+
+/* answer the connection setup with the screens of the recording */
+static int
+stub_setup(struct stub *stub)
+{
+	const struct record_header *header = stub->replay->header;
+	xcb_setup_request_t	request;
+	xcb_setup_t	       *setup;
+	xcb_format_t	       *format;
+	xcb_screen_t	       *screen;
+	xcb_depth_t	       *depth;
+	xcb_visualtype_t       *visual;
+	uint8_t		       *buf, *p;
+	size_t			len, skip;
+	int			i, ret;
+
+	if (stub_read(stub->fd, &request, sizeof request) == -1)
+		return -1;
+	skip = ((request.authorization_protocol_name_len + 3) & ~3) +
+	    ((request.authorization_protocol_data_len + 3) & ~3);
+	if (skip > STUB_REQUEST_MAX ||
+	    stub_read(stub->fd, stub->request, skip) == -1)
+		return -1;
+
+	len = sizeof *setup + sizeof STUB_VENDOR - 1 + sizeof *format +
+	    header->nscreens * (sizeof *screen + sizeof *depth + sizeof *visual);
+	if ((buf = calloc(1, len)) == NULL)
+		return -1;
+
+	setup = (xcb_setup_t *)buf;
+	setup->status = 1;
+	setup->protocol_major_version = 11;
+	setup->length = (len - 8) / 4;
+	setup->resource_id_base = header->resource_id_base;
+	setup->resource_id_mask = header->resource_id_mask;
+	setup->vendor_len = sizeof STUB_VENDOR - 1;
+	setup->maximum_request_length = 65535;
+	setup->roots_len = header->nscreens;
+	setup->pixmap_formats_len = 1;
+	setup->bitmap_format_scanline_unit = 32;
+	setup->bitmap_format_scanline_pad = 32;
+	setup->min_keycode = header->min_keycode;
+	setup->max_keycode = header->max_keycode;
+	p = buf + sizeof *setup;
+	memcpy(p, STUB_VENDOR, sizeof STUB_VENDOR - 1);
+	p += sizeof STUB_VENDOR - 1;
+
+	format = (xcb_format_t *)p;
+	format->depth = 24;
+	format->bits_per_pixel = 32;
+	format->scanline_pad = 32;
+	p += sizeof *format;
+
+	for (i = 0; i < header->nscreens; ++i) {
+		screen = (xcb_screen_t *)p;
+		screen->root = header->screens[i].root;
+		screen->width_in_pixels = header->screens[i].width;
+		screen->height_in_pixels = header->screens[i].height;
+		screen->root_visual = header->screens[i].root_visual;
+		screen->root_depth = header->screens[i].root_depth;
+		screen->allowed_depths_len = 1;
+		p += sizeof *screen;
+
+		depth = (xcb_depth_t *)p;
+		depth->depth = header->screens[i].root_depth;
+		depth->visuals_len = 1;
+		p += sizeof *depth;
+
+		visual = (xcb_visualtype_t *)p;
+		visual->visual_id = header->screens[i].root_visual;
+		visual->_class = XCB_VISUAL_CLASS_TRUE_COLOR;
+		visual->bits_per_rgb_value = 8;
+		visual->colormap_entries = 256;
+		visual->red_mask = 0xff0000;
+		visual->green_mask = 0x00ff00;
+		visual->blue_mask = 0x0000ff;
+		p += sizeof *visual;
+	}
+
+	ret = stub_write(stub->fd, buf, len);
+	free(buf);
+	return ret;
+}
+
+static int
+stub_reply(struct stub *stub, uint8_t opcode)
+{
+	const struct record_header *header = stub->replay->header;
+	const xcb_keysym_t     *keysyms;
+	uint8_t			reply[32 + 255 * 8 * sizeof(xcb_keysym_t)];
+	uint32_t		length = 0;
+	uint8_t			first, count;
+	size_t			n;
+
+	memset(reply, 0, 32);
+	reply[0] = 1;
+	memcpy(reply + 2, &stub->sequence, sizeof stub->sequence);
+
+	switch (opcode) {
+	case XCB_GET_WINDOW_ATTRIBUTES:
+		length = 3;
+		memset(reply + 32, 0, length * 4);
+		break;
+
+	case XCB_INTERN_ATOM:
+		/* distinct atoms so that the atoms[] table stays meaningful */
+		stub->atoms++;
+		memcpy(reply + 8, &stub->atoms, sizeof stub->atoms);
+		break;
+
+	case XCB_GET_KEYBOARD_MAPPING:
+		first = stub->request[4];
+		count = stub->request[5];
+		if (first < header->min_keycode ||
+		    first + count - 1 > header->max_keycode ||
+		    header->keysyms_per_keycode > 8)
+			break;
+		n = (size_t)count * header->keysyms_per_keycode;
+		keysyms = stub->replay->keysyms +
+		    (first - header->min_keycode) * header->keysyms_per_keycode;
+		reply[1] = header->keysyms_per_keycode;
+		memcpy(reply + 32, keysyms, n * sizeof(xcb_keysym_t));
+		length = n;
+		break;
+
+	case XCB_GET_GEOMETRY:
+	case XCB_QUERY_TREE:
+	case XCB_GET_ATOM_NAME:
+	case XCB_GET_PROPERTY:
+	case XCB_GRAB_POINTER:
+	case XCB_GRAB_KEYBOARD:
+	case XCB_QUERY_POINTER:
+	case XCB_GET_INPUT_FOCUS:
+	case XCB_QUERY_EXTENSION:
+	case XCB_GET_MODIFIER_MAPPING:
+		/* all zeroes: success, nothing set, nothing found */
+		break;
+
+	default:
+		return 0;
+	}
+
+	memcpy(reply + 4, &length, sizeof length);
+	return stub_write(stub->fd, reply, 32 + length * 4);
+}
+
+static int
+stub_read(int fd, void *buf, size_t len)
+{
+	uint8_t	       *p = buf;
+	ssize_t		n;
+
+	while (len) {
+		if ((n = read(fd, p, len)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int
+stub_write(int fd, const void *buf, size_t len)
+{
+	const uint8_t  *p = buf;
+	ssize_t		n;
+
+	while (len) {
+		if ((n = write(fd, p, len)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "trace.h"
+
+int	trace_enabled;
+int	trace_current = TRACE_OP_NONE;
+uint32_t trace_seen;
+
+static struct trace_header     *header;
+static struct trace_record     *records;
+static size_t			mapsize;
+
+/* time spent in operations, kept whether there is a trace file or not */
+static struct {
+	uint64_t	begin;
+	uint64_t	calls;
+	uint64_t	ns;
+} stats[TRACE_OP_COUNT];
+
+static const char *op_names[] = {
+#define	TRACE_OP_NAME(op, name)	name,
+	TRACE_OPS(TRACE_OP_NAME)
+#undef	TRACE_OP_NAME
+};
+
+/* the ring lives in a shared mapping, a crash does not lose the trace */
+static int
+trace_map(int fd, const char *path)
+{
+	void   *p;
+
+	mapsize = sizeof *header + TRACE_RECORDS * sizeof *records;
+	if (ftruncate(fd, mapsize) == -1) {
+		log_warn("trace_open: ftruncate");
+		close(fd);
+		return -1;
+	}
+	p = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		log_warn("trace_open: mmap");
+		return -1;
+	}
+
+	header = p;
+	records = (struct trace_record *)(header + 1);
+	memcpy(header->magic, TRACE_MAGIC, sizeof header->magic);
+	header->record_size = sizeof *records;
+	header->capacity = TRACE_RECORDS;
+	header->count = 0;
+
+	log_info("tracing to %s", path);
+	trace_enabled = 1;
+	return 0;
+}
+
+int
+trace_open(const char *path)
+{
+	int	fd;
+
+	if (header)
+		return 0;
+
+	if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600)) == -1) {
+		log_warn("trace_open: %s", path);
+		return -1;
+	}
+	return trace_map(fd, path);
+}
+
+/* account operations without recording anything, used by replays */
+void
+trace_stats_start(void)
+{
+	memset(stats, 0, sizeof stats);
+	trace_enabled = 1;
+}
+
+void
+trace_stats(enum trace_op op, uint64_t *calls, uint64_t *ns)
+{
+	*calls = stats[op].calls;
+	*ns = stats[op].ns;
+}
+
+const char *
+trace_op_name(enum trace_op op)
+{
+	return op_names[op];
+}
+
+void
+trace_close(void)
+{
+	trace_enabled = 0;
+	if (header == NULL)
+		return;
+	munmap(header, mapsize);
+	header = NULL;
+	records = NULL;
+}
+
+/*
+ * the first toggle without a trace file creates one with a name nobody
+ * can predict, in the user's runtime directory when there is one.
+ */
+void
+trace_toggle(void)
+{
+	const char     *dir;
+	char		path[PATH_MAX];
+	int		fd;
+
+	if (header == NULL) {
+		if ((dir = getenv("XDG_RUNTIME_DIR")) == NULL || *dir == '\0')
+			dir = "/tmp";
+		if (snprintf(path, sizeof path, "%s/fion-XXXXXX.trace", dir) >= (int)sizeof path) {
+			log_warnx("trace_toggle: %s: path too long", dir);
+			return;
+		}
+		if ((fd = mkostemps(path, strlen(".trace"), O_CLOEXEC)) == -1) {
+			log_warn("trace_toggle: %s", path);
+			return;
+		}
+		trace_map(fd, path);
+		return;
+	}
+	trace_enabled = !trace_enabled;
+	log_info("tracing %s", trace_enabled ? "resumed" : "paused");
+}
+
+void
+trace_record(enum trace_kind kind, uint8_t opcode, uint32_t a, uint32_t b, uint32_t c)
+{
+	struct trace_record    *rec;
+	struct timespec		ts;
+	uint64_t		ns;
+
+	if (records == NULL && kind != TRACE_OP_BEGIN && kind != TRACE_OP_END)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	if (kind == TRACE_OP_BEGIN)
+		stats[opcode].begin = ns;
+	else if (kind == TRACE_OP_END && stats[opcode].begin) {
+		stats[opcode].calls++;
+		stats[opcode].ns += ns - stats[opcode].begin;
+		stats[opcode].begin = 0;
+	}
+	if (records == NULL)
+		return;
+
+	rec = &records[header->count++ % TRACE_RECORDS];
+	rec->ns = ns;
+	rec->kind = kind;
+	rec->opcode = opcode;
+	rec->pad = 0;
+	rec->a = a;
+	rec->b = b;
+	rec->c = c;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _TRACE_H_
+#define	_TRACE_H_
+
+#include <stdint.h>
+
+/*
+ * the trace file is a header followed by a ring of fixed size records,
+ * it is mapped by fion and read back by fion-trace.
+ */
+#define	TRACE_MAGIC	"FIONTRC1"
+#define	TRACE_RECORDS	(1 << 20)
+
+struct trace_header {
+	char		magic[8];
+	uint32_t	record_size;
+	uint32_t	capacity;
+	uint64_t	count;		/* records written, wraps over capacity */
+};
+
+enum trace_kind {
+	TRACE_EVENT,			/* opcode is the X event type */
+	TRACE_EVENT_DONE,
+	TRACE_REQUEST,			/* opcode is the X request major, a the
+					 * resource, b the enum trace_op causing
+					 * it, c the sequence */
+	TRACE_OP_BEGIN,			/* opcode is an enum trace_op */
+	TRACE_OP_END,
+};
+
+struct trace_record {
+	uint64_t	ns;		/* CLOCK_MONOTONIC */
+	uint8_t		kind;
+	uint8_t		opcode;
+	uint16_t	pad;
+	uint32_t	a;
+	uint32_t	b;
+	uint32_t	c;
+};
+
+#define	TRACE_OPS(X)						\
+	X(WORKSPACE_CREATE,	"layout_workspace_create")	\
+	X(WORKSPACE_DESTROY,	"layout_workspace_destroy")	\
+	X(WORKSPACE_NEXT,	"layout_workspace_next")	\
+	X(WORKSPACE_PREV,	"layout_workspace_prev")	\
+	X(TILE_SPLIT,		"layout_tile_split")		\
+	X(TILE_DESTROY,		"layout_tile_destroy")		\
+	X(TILE_NEXT,		"layout_tile_next")		\
+	X(TILE_PREV,		"layout_tile_prev")		\
+	X(CLIENT_INTAKE,	"layout_client_intake")		\
+	X(COMMIT,		"scene_commit")			\
+	X(UPDATE,		"layout_update")		\
+	X(RENDER,		"window_render")		\
+	X(FLUSH,		"event_flush")
+
+enum trace_op {
+#define	TRACE_OP_ENUM(op, name)	TRACE_OP_##op,
+	TRACE_OPS(TRACE_OP_ENUM)
+#undef	TRACE_OP_ENUM
+	TRACE_OP_COUNT
+};
+#define	TRACE_OP_NONE	TRACE_OP_COUNT	/* outside of any operation */
+
+/* recording costs a test of trace_enabled when it is off */
+#define	TRACE(kind, opcode, a, b, c) do {				\
+	if (trace_enabled)						\
+		trace_record((kind), (opcode), (a), (b), (c));		\
+} while (0)
+
+/* the operation in progress is known whether tracing or not */
+#define	TRACE_BEGIN(op) do {						\
+	trace_current = TRACE_OP_##op;					\
+	trace_seen |= 1U << TRACE_OP_##op;				\
+	TRACE(TRACE_OP_BEGIN, TRACE_OP_##op, 0, 0, 0);			\
+} while (0)
+#define	TRACE_END(op) do {						\
+	TRACE(TRACE_OP_END, TRACE_OP_##op, 0, 0, 0);			\
+	trace_current = TRACE_OP_NONE;					\
+} while (0)
+
+extern int	trace_enabled;
+extern int	trace_current;
+extern uint32_t	trace_seen;	/* operations begun, cleared by the watchdog */
+
+int	trace_open(const char *);
+void	trace_stats_start(void);
+void	trace_stats(enum trace_op, uint64_t *, uint64_t *);
+const char *trace_op_name(enum trace_op);
+void	trace_close(void);
+void	trace_toggle(void);
+void	trace_record(enum trace_kind, uint8_t, uint32_t, uint32_t, uint32_t);
+
+#endif
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <limits.h>
 
+#include "pool.h"
 #include "tree.h"
 
 struct treeentry {
@@ -34,6 +35,9 @@ struct treeentry {
 
 static int treeentry_cmp(struct treeentry *, struct treeentry *);
 
+static struct pool treeentry_pool =
+    POOL_INITIALIZER("treeentry", sizeof(struct treeentry));
+
 SPLAY_PROTOTYPE(_tree, treeentry, entry, treeentry_cmp);
 
 int
@@ -53,8 +57,7 @@ tree_set(struct tree *t, uint64_t id, void *data)
 
 	key.id = id;
 	if ((entry = SPLAY_FIND(_tree, &t->tree, &key)) == NULL) {
-		if ((entry = malloc(sizeof *entry)) == NULL)
-			err(1, "tree_set: malloc");
+		entry = pool_get(&treeentry_pool);
 		entry->id = id;
 		SPLAY_INSERT(_tree, &t->tree, entry);
 		old = NULL;
@@ -72,8 +75,7 @@ tree_xset(struct tree *t, uint64_t id, void *data)
 {
 	struct treeentry	*entry;
 
-	if ((entry = malloc(sizeof *entry)) == NULL)
-		err(1, "tree_xset: malloc");
+	entry = pool_get(&treeentry_pool);
 	entry->id = id;
 	entry->data = data;
 	if (SPLAY_INSERT(_tree, &t->tree, entry))
@@ -117,7 +119,7 @@ tree_pop(struct tree *t, uint64_t id)
 
 	data = entry->data;
 	SPLAY_REMOVE(_tree, &t->tree, entry);
-	free(entry);
+	pool_put(&treeentry_pool, entry);
 	t->count -= 1;
 
 	return (data);
@@ -135,7 +137,7 @@ tree_xpop(struct tree *t, uint64_t id)
 
 	data = entry->data;
 	SPLAY_REMOVE(_tree, &t->tree, entry);
-	free(entry);
+	pool_put(&treeentry_pool, entry);
 	t->count -= 1;
 
 	return (data);
@@ -154,7 +156,7 @@ tree_poproot(struct tree *t, uint64_t *id, void **data)
 	if (data)
 		*data = entry->data;
 	SPLAY_REMOVE(_tree, &t->tree, entry);
-	free(entry);
+	pool_put(&treeentry_pool, entry);
 	t->count -= 1;
 
 	return (1);
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2019 Gilles Chehade <gilles@poolp.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * every event handler, client placement and status update is timed into a
+ * histogram, and an event loop iteration running over budget is reported
+ * with what it spent its time on.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "fion.h"
+#include "hist.h"
+#include "log.h"
+#include "proto.h"
+
+/* event types first, then the work done outside of handlers */
+#define	SLOT_EVENTS	(XCB_GE_GENERIC + 1)
+#define	SLOT_INTAKE	SLOT_EVENTS
+#define	SLOT_UPDATE	(SLOT_EVENTS + 1)
+#define	SLOT_COUNT	(SLOT_EVENTS + 2)
+
+static struct hist	hists[SLOT_COUNT];
+static uint64_t		budget = WATCHDOG_BUDGET * 1000000ULL;
+
+/* the iteration in progress */
+static struct {
+	uint64_t	start;
+	uint64_t	events;
+	uint64_t	events_ns;
+	uint64_t	slowest_ns;
+	int		slowest;
+	uint64_t	intake_ns;
+	uint64_t	update_ns;
+} it;
+
+static const char *
+slot_name(int slot)
+{
+	if (slot == SLOT_INTAKE)
+		return trace_op_name(TRACE_OP_CLIENT_INTAKE);
+	if (slot == SLOT_UPDATE)
+		return trace_op_name(TRACE_OP_UPDATE);
+	return proto_event_name(slot);
+}
+
+static void
+slot_add(int slot, uint64_t ns)
+{
+	hist_add(&hists[slot], ns);
+	if (ns > it.slowest_ns) {
+		it.slowest_ns = ns;
+		it.slowest = slot;
+	}
+}
+
+uint64_t
+watchdog_clock(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err(1, "clock_gettime");
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void
+watchdog_budget(int ms)
+{
+	budget = ms * 1000000ULL;
+}
+
+/* called when the event loop wakes up */
+void
+watchdog_start(void)
+{
+	memset(&it, 0, sizeof it);
+	it.slowest = -1;
+	it.start = watchdog_clock();
+	trace_seen = 0;
+}
+
+void
+watchdog_event(uint8_t type, uint64_t start)
+{
+	uint64_t	ns = watchdog_clock() - start;
+
+	it.events++;
+	it.events_ns += ns;
+	if (type < SLOT_EVENTS)
+		slot_add(type, ns);
+}
+
+void
+watchdog_intake(uint64_t start)
+{
+	uint64_t	ns = watchdog_clock() - start;
+
+	it.intake_ns += ns;
+	slot_add(SLOT_INTAKE, ns);
+}
+
+void
+watchdog_update(uint64_t start)
+{
+	uint64_t	ns = watchdog_clock() - start;
+
+	it.update_ns += ns;
+	slot_add(SLOT_UPDATE, ns);
+}
+
+/* called once the iteration is committed and flushed */
+void
+watchdog_check(struct wm *wm)
+{
+	char		ops[256], requests[512];
+	uint64_t	ns;
+	size_t		len;
+	int		op;
+
+	ns = watchdog_clock() - it.start;
+	account_iteration(requests, sizeof requests);
+	if (budget == 0 || ns <= budget)
+		return;
+
+	len = 0;
+	ops[0] = '\0';
+	for (op = 0; op < TRACE_OP_COUNT; ++op)
+		if ((trace_seen & (1U << op)) && len < sizeof ops)
+			len += snprintf(ops + len, sizeof ops - len, " %s",
+			    trace_op_name(op));
+
+	log_warnx("watchdog: iteration took %.3fms, budget %.3fms",
+	    ns / 1e6, budget / 1e6);
+	log_warnx("watchdog: %llu events in %.3fms, slowest %s %.3fms,"
+	    " intake %.3fms, status %.3fms",
+	    (unsigned long long)it.events, it.events_ns / 1e6,
+	    it.slowest == -1 ? "none" : slot_name(it.slowest), it.slowest_ns / 1e6,
+	    it.intake_ns / 1e6, it.update_ns / 1e6);
+	log_warnx("watchdog: operations:%s", ops[0] ? ops : " none");
+	log_warnx("watchdog: requests:%s", requests[0] ? requests : " none");
+}
+
+void
+watchdog_dump(void)
+{
+	const struct hist      *hist;
+	int			slot;
+
+	for (slot = 0; slot < SLOT_COUNT; ++slot) {
+		hist = &hists[slot];
+		if (hist->count == 0)
+			continue;
+		log_info("%s: %llu calls, p50 %.1fus, p99 %.1fus, max %.1fus",
+		    slot_name(slot), (unsigned long long)hist->count,
+		    hist_percentile(hist, 50) / 1e3,
+		    hist_percentile(hist, 99) / 1e3, hist->max / 1e3);
+	}
+}
@@ -14,6 +14,11 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+/*
+ * X backend of the scene: render operations produced by scene_commit()
+ * are turned into requests here, once per batch.
+ */
+
 #include <err.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,255 +28,324 @@
 #include "fion.h"
 #include "log.h"
 
-static uint32_t
-rgb_pixel(const char *rgb)
-{
-        char buf[3] = { 0, 0, 0 };
-        uint32_t r, g, b;
-
-        r = strtol(memcpy(buf, rgb+1, 2), NULL, 16);
-        g = strtol(memcpy(buf, rgb+3, 2), NULL, 16);
-        b = strtol(memcpy(buf, rgb+5, 2), NULL, 16);
+static void	window_create(struct wm *wm, const struct op *op);
+static void	window_text(struct wm *wm, const struct op *op);
 
-        return ((r << 16) + (g << 8) + b);
-        
-}
+static struct render *render_get(struct wm *wm, xcb_screen_t *xcb_screen, const char *font_name, int cause);
+static void render_error(struct wm *wm, xcb_generic_error_t *error, void *arg);
+static void render_release(struct wm *wm, xcb_window_t xcb_root);
 
-struct window *
-window_create_screen(struct wm *wm, struct window *window)
+xcb_window_t
+window_generate_id(struct wm *wm)
 {
-        uint32_t        mask = XCB_CW_BACK_PIXEL;
-        uint32_t        values[2] = {
-		rgb_pixel("#335599"),
-        };
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_screen->root,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-            0,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
+	return xcb_generate_id(wm->conn);
 }
 
-struct window *
-window_create_status(struct wm *wm, struct window *window)
+static void
+window_create(struct wm *wm, const struct op *op)
 {
-        uint32_t        mask = XCB_CW_BACK_PIXEL|XCB_CW_BORDER_PIXEL;
-        uint32_t        values[2] = {
-		rgb_pixel("#000000"),
-		rgb_pixel("#0000ff"),
-        };
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_parent,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-            window->border_width,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
-}
+	xcb_void_cookie_t	cookie;
+	uint32_t	mask = XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL;
+	uint32_t	values[3] = {
+		0x000000,
+		op->pixel,
+		0
+	};
 
-struct window *
-window_create_workarea(struct wm *wm, struct window *window)
-{
-        uint32_t        mask = XCB_CW_BACK_PIXEL|XCB_CW_BORDER_PIXEL;
-        uint32_t        values[2] = {
-		rgb_pixel("#000000"),
-		rgb_pixel("#0000ff"),
-        };
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_parent,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-	    window->border_width,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
-}
+	if (op->window_type == WT_TILE) {
+		mask |= XCB_CW_EVENT_MASK;
+		values[2] = 0
+		    | XCB_EVENT_MASK_ENTER_WINDOW
+		    | XCB_EVENT_MASK_LEAVE_WINDOW
+		    | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY
+		    | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT;
+	}
+	else if (op->window_type == WT_STATUSBAR) {
+		/* the status line is only drawn when it changes */
+		mask |= XCB_CW_EVENT_MASK;
+		values[2] = XCB_EVENT_MASK_EXPOSURE;
+	}
 
-struct window *
-window_create_workspace(struct wm *wm, struct window *window)
-{
-        uint32_t        mask = XCB_CW_BACK_PIXEL|XCB_CW_BORDER_PIXEL;
-        uint32_t        values[2] = {
-		rgb_pixel("#000000"),
-		rgb_pixel("#335599"),
-        };
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_parent,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-	    window->border_width,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
+	cookie = xcb_create_window(wm->conn,
+	    XCB_COPY_FROM_PARENT,
+	    op->xcb_window,
+	    op->xcb_parent,
+	    op->x,
+	    op->y,
+	    op->width,
+	    op->height,
+	    op->border_width,
+	    XCB_WINDOW_CLASS_INPUT_OUTPUT,
+	    op->xcb_screen->root_visual,
+	    mask, values);
+	account_request(op->cause, XCB_CREATE_WINDOW,
+	    sizeof(xcb_create_window_request_t) +
+	    (mask & XCB_CW_EVENT_MASK ? 12 : 8), op->xcb_window, cookie.sequence);
 }
 
-struct window *
-window_create_tilefork(struct wm *wm, struct window *window)
+void
+window_raise(struct wm *wm, struct window *window)
 {
-        uint32_t        mask = XCB_CW_BACK_PIXEL|XCB_CW_BORDER_PIXEL;
-        uint32_t        values[2] = {
-		rgb_pixel("#000000"),
-		rgb_pixel("#335599"),
-        };
-        
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_parent,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-	    window->border_width,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
-}
+	xcb_void_cookie_t cookie;
+        uint32_t value = XCB_STACK_MODE_ABOVE;
 
-struct window *
-window_create_tile(struct wm *wm, struct window *window)
-{
-        uint32_t        mask = XCB_CW_BACK_PIXEL|XCB_CW_BORDER_PIXEL|XCB_CW_EVENT_MASK;
-        uint32_t        values[3] = {
-		rgb_pixel("#000000"),
-		rgb_pixel("#335599"),
-		0
-		| XCB_EVENT_MASK_ENTER_WINDOW
-		| XCB_EVENT_MASK_LEAVE_WINDOW
-		| XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY
-	};
-        
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_parent,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-	    window->border_width,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
+        cookie = xcb_configure_window(wm->conn, window->xcb_window, XCB_CONFIG_WINDOW_STACK_MODE, &value);
+	account_request(trace_current, XCB_CONFIGURE_WINDOW,
+	    sizeof(xcb_configure_window_request_t) + 4, window->xcb_window,
+	    cookie.sequence);
 }
 
-struct window *
-window_create_client(struct wm *wm, struct window *window)
+void
+window_border_width(struct wm *wm, struct window *window, uint32_t width)
 {
-        uint32_t        mask = XCB_CW_BACK_PIXEL|XCB_CW_BORDER_PIXEL;
-        uint32_t        values[2] = {
-		rgb_pixel("#000000"),
-		rgb_pixel("#ffffff"),
+	xcb_void_cookie_t cookie;
+	uint16_t mask =
+	    XCB_CONFIG_WINDOW_BORDER_WIDTH;
+        uint32_t values[1] = {
+		width
         };
-
-        xcb_create_window(wm->conn,
-            XCB_COPY_FROM_PARENT,
-            window->xcb_window,
-            window->xcb_parent,
-            window->x,
-            window->y,
-            window->width,
-            window->height,
-	    window->border_width,
-            XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            window->xcb_screen->root_visual,
-            mask, values);
-        return window;
+	window->border_width = width;
+	cookie = xcb_configure_window(wm->conn, window->xcb_window, mask, values);
+	account_request(trace_current, XCB_CONFIGURE_WINDOW,
+	    sizeof(xcb_configure_window_request_t) + 4, window->xcb_window,
+	    cookie.sequence);
 }
 
+/* ICCCM 4.1.5: a refused ConfigureRequest is answered with a synthetic notify */
 void
-window_map(struct wm *wm, struct window *window)
+window_configure_notify(struct wm *wm, struct window *window)
 {
-	xcb_map_window(wm->conn, window->xcb_window);
-}
+	xcb_configure_notify_event_t	ev;
+	xcb_void_cookie_t		cookie;
+	struct window		       *parent;
 
-void
-window_unmap(struct wm *wm, struct window *window)
-{
-	xcb_unmap_window(wm->conn, window->xcb_window);
+	memset(&ev, 0, sizeof ev);
+	ev.response_type = XCB_CONFIGURE_NOTIFY;
+	ev.event = window->xcb_window;
+	ev.window = window->xcb_window;
+	ev.above_sibling = XCB_NONE;
+	ev.x = window->x;
+	ev.y = window->y;
+	ev.width = window->width;
+	ev.height = window->height;
+	ev.border_width = window->border_width;
+
+	/* coordinates are relative to the root */
+	for (parent = window->parent; parent; parent = parent->parent) {
+		ev.x += parent->x + parent->border_width;
+		ev.y += parent->y + parent->border_width;
+	}
+
+	cookie = xcb_send_event(wm->conn, 0, window->xcb_window,
+	    XCB_EVENT_MASK_STRUCTURE_NOTIFY, (const char *)&ev);
+	account_request(trace_current, XCB_SEND_EVENT,
+	    sizeof(xcb_send_event_request_t), window->xcb_window,
+	    cookie.sequence);
 }
 
+/* emit the requests for the operations produced since the last call */
 void
-window_destroy(struct wm *wm, struct window *window)
+window_render(struct wm *wm)
 {
-	xcb_destroy_window(wm->conn, window->xcb_window);
+	const struct op	       *op;
+	xcb_void_cookie_t	cookie;
+	uint32_t		values[4];
+	size_t			i;
+	int			n;
+
+	for (i = 0; i < wm->nops; ++i) {
+		op = &wm->ops[i];
+		switch (op->type) {
+		case OP_CREATE:
+			window_create(wm, op);
+			break;
+
+		case OP_DESTROY:
+			cookie = xcb_destroy_window(wm->conn, op->xcb_window);
+			account_request(op->cause, XCB_DESTROY_WINDOW,
+			    sizeof(xcb_destroy_window_request_t), op->xcb_window,
+			    cookie.sequence);
+			break;
+
+		case OP_REPARENT:
+			cookie = xcb_reparent_window(wm->conn, op->xcb_window,
+			    op->xcb_parent, op->x, op->y);
+			account_request(op->cause, XCB_REPARENT_WINDOW,
+			    sizeof(xcb_reparent_window_request_t), op->xcb_window,
+			    cookie.sequence);
+			break;
+
+		case OP_CONFIGURE:
+			n = 0;
+			if (op->mask & OP_CONFIGURE_X)
+				values[n++] = op->x;
+			if (op->mask & OP_CONFIGURE_Y)
+				values[n++] = op->y;
+			if (op->mask & OP_CONFIGURE_WIDTH)
+				values[n++] = op->width;
+			if (op->mask & OP_CONFIGURE_HEIGHT)
+				values[n++] = op->height;
+			cookie = xcb_configure_window(wm->conn,
+			    op->xcb_window, op->mask, values);
+			op->window->sent.sequence = cookie.sequence;
+			account_request(op->cause, XCB_CONFIGURE_WINDOW,
+			    sizeof(xcb_configure_window_request_t) + n * 4,
+			    op->xcb_window, cookie.sequence);
+			break;
+
+		case OP_BORDER:
+			cookie = xcb_change_window_attributes(wm->conn, op->xcb_window,
+			    XCB_CW_BORDER_PIXEL, &op->pixel);
+			account_request(op->cause, XCB_CHANGE_WINDOW_ATTRIBUTES,
+			    sizeof(xcb_change_window_attributes_request_t) + 4,
+			    op->xcb_window, cookie.sequence);
+			break;
+
+		case OP_MAP:
+			cookie = xcb_map_window(wm->conn, op->xcb_window);
+			account_request(op->cause, XCB_MAP_WINDOW,
+			    sizeof(xcb_map_window_request_t), op->xcb_window,
+			    cookie.sequence);
+			break;
+
+		case OP_UNMAP:
+			cookie = xcb_unmap_window(wm->conn, op->xcb_window);
+			account_request(op->cause, XCB_UNMAP_WINDOW,
+			    sizeof(xcb_unmap_window_request_t), op->xcb_window,
+			    cookie.sequence);
+			break;
+
+		case OP_TEXT:
+			window_text(wm, op);
+			break;
+		}
+	}
+	scene_clear(wm);
 }
 
 void
-window_raise(struct wm *wm, struct window *window)
+window_finalize(struct wm *wm)
 {
-        uint32_t value = XCB_STACK_MODE_ABOVE;
+	uint64_t root;
 
-        xcb_configure_window(wm->conn, window->xcb_window, XCB_CONFIG_WINDOW_STACK_MODE, &value);
+	while (tree_root(&wm->render_by_screen, &root, NULL))
+		render_release(wm, root);
+	xcb_flush(wm->conn);
+	account_flush(wm);
 }
 
-void
-window_reparent(struct wm *wm, struct window *parent, struct window *window)
+
+/**/
+static void
+window_text(struct wm *wm, const struct op *op)
 {
-        xcb_reparent_window(wm->conn, window->xcb_window, parent->xcb_window, 0, 0);
+	struct render	    *render;
+	uint8_t              length;
+	xcb_void_cookie_t    cookie;
+
+	render = render_get(wm, op->xcb_screen, STATUS_FONT, op->cause);
+	if (render->failed) {
+		/* drop it so that the next redraw tries again */
+		render_release(wm, op->xcb_screen->root);
+		return;
+	}
+
+	length = strlen (op->text);
+
+	cookie = xcb_image_text_8 (wm->conn, length, op->xcb_window, render->gc,
+	    op->x,
+	    op->y, op->text);
+	account_request(op->cause, XCB_IMAGE_TEXT_8,
+	    sizeof(xcb_image_text_8_request_t) + ((length + 3) & ~3),
+	    op->xcb_window, cookie.sequence);
 }
 
-void
-window_resize(struct wm *wm, struct window *window)
+/*
+ * font and graphics context are created once per screen and reused by every
+ * redraw, they are only rebuilt when a different font is requested.
+ *
+ * requests are not checked, a failure is reported to render_error() by the
+ * event loop and the status bar is simply not drawn until the next attempt.
+ */
+static struct render *
+render_get(struct wm *wm, xcb_screen_t *xcb_screen, const char *font_name, int cause)
 {
-        uint32_t mask =
-            XCB_CONFIG_WINDOW_Y |
-            XCB_CONFIG_WINDOW_X |
-            XCB_CONFIG_WINDOW_WIDTH |
-            XCB_CONFIG_WINDOW_HEIGHT;
-        uint32_t values[4] = {
-                window->x,
-                window->y,
-                window->width,
-                window->height,
-        };
-        xcb_configure_window(wm->conn, window->xcb_window, mask, values);
+	uint32_t             value_list[3];
+	xcb_font_t           font;
+	uint32_t             mask;
+	struct render	    *render;
+	xcb_void_cookie_t    cookie;
+
+	render = tree_get(&wm->render_by_screen, xcb_screen->root);
+	if (render != NULL) {
+		if (strcmp(render->font_name, font_name) == 0)
+			return render;
+		render_release(wm, xcb_screen->root);
+	}
+
+	if ((render = calloc(1, sizeof(*render))) == NULL)
+		err(1, "render_get: calloc");
+	if ((render->font_name = strdup(font_name)) == NULL)
+		err(1, "render_get: strdup");
+
+	font = xcb_generate_id (wm->conn);
+	render->cookie_font = xcb_open_font (wm->conn, font,
+	    strlen (font_name),
+	    font_name);
+	event_expect_error(wm, render->cookie_font, "open_font", render_error, render);
+	account_request(cause, XCB_OPEN_FONT,
+	    sizeof(xcb_open_font_request_t) + ((strlen(font_name) + 3) & ~3),
+	    font, render->cookie_font.sequence);
+
+	render->gc = xcb_generate_id (wm->conn);
+	mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND | XCB_GC_FONT;
+	value_list[0] = xcb_screen->white_pixel;
+	value_list[1] = xcb_screen->black_pixel;
+	value_list[2] = font;
+	render->cookie_gc = xcb_create_gc (wm->conn, render->gc,
+	    xcb_screen->root, mask, value_list);
+	event_expect_error(wm, render->cookie_gc, "create_gc", render_error, render);
+	account_request(cause, XCB_CREATE_GC,
+	    sizeof(xcb_create_gc_request_t) + 12, render->gc,
+	    render->cookie_gc.sequence);
+
+	/* the gc holds its own reference to the font */
+	cookie = xcb_close_font (wm->conn, font);
+	account_request(cause, XCB_CLOSE_FONT, sizeof(xcb_close_font_request_t),
+	    font, cookie.sequence);
+
+	tree_xset(&wm->render_by_screen, xcb_screen->root, render);
+	return render;
 }
 
-void
-window_border_color(struct wm *wm, struct window *window, const char *rgb_color)
+static void
+render_error(struct wm *wm, xcb_generic_error_t *error, void *arg)
 {
-        uint32_t        mask = XCB_CW_BORDER_PIXEL;
-        uint32_t        values[1] = {
-		rgb_pixel(rgb_color),
-        };
+	struct render *render = arg;
 
-	xcb_change_window_attributes(wm->conn, window->xcb_window, mask, values);
+	log_warnx("status: can't set up font %s: error %d",
+	    render->font_name, error->error_code);
+	render->failed = 1;
 }
 
-void
-window_border_width(struct wm *wm, struct window *window, uint32_t width)
+static void
+render_release(struct wm *wm, xcb_window_t xcb_root)
 {
-	uint16_t mask =
-	    XCB_CONFIG_WINDOW_BORDER_WIDTH;
-        uint32_t values[1] = {
-		width
-        };
-	window->border_width = width;
-	xcb_configure_window(wm->conn, window->xcb_window, mask, values);
+	xcb_void_cookie_t cookie;
+	struct render *render;
+
+	render = tree_pop(&wm->render_by_screen, xcb_root);
+	if (render == NULL)
+		return;
+
+	event_forget_error(wm, render->cookie_font);
+	event_forget_error(wm, render->cookie_gc);
+	if (! render->failed) {
+		cookie = xcb_free_gc (wm->conn, render->gc);
+		account_request(trace_current, XCB_FREE_GC,
+		    sizeof(xcb_free_gc_request_t), render->gc, cookie.sequence);
+	}
+	free(render->font_name);
+	free(render);
 }
+/**/
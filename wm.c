@@ -26,35 +26,23 @@
 void
 wm_run_terminal(struct wm *wm, xcb_window_t xcb_root)
 {
-	log_debug("run_terminal");
-	pid_t	pid;
-
-	if ((pid = fork()) < 0) {
-		warn("wm_run_terminal");
-		return;
-	}
-	if (pid)
-		return;
+	static const char *const argv[] = {
+		"xterm", "-fg", "white", "-bg", "black", NULL
+	};
 
-	execlp("xterm", "xterm", "-fg", "white", "-bg", "black", NULL);
-	exit(1);
+	log_debug("run_terminal");
+	launcher_spawn(wm, argv);
 }
 
 void
 wm_run_xeyes(struct wm *wm, xcb_window_t xcb_root)
 {
-	log_debug("run_xeyes");
-	pid_t	pid;
-
-	if ((pid = fork()) < 0) {
-		warn("wm_run_xeyes");
-		return;
-	}
-	if (pid)
-		return;
+	static const char *const argv[] = {
+		"xeyes", NULL
+	};
 
-	execlp("xeyes", "xeyes", NULL);
-	exit(1);
+	log_debug("run_xeyes");
+	launcher_spawn(wm, argv);
 }
 
 
@@ -62,61 +50,79 @@ void
 wm_workspace_create(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("workspace_create");
+	TRACE_BEGIN(WORKSPACE_CREATE);
 	layout_workspace_create(wm, xcb_root);
+	TRACE_END(WORKSPACE_CREATE);
 }
 
 void
 wm_workspace_destroy(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("workspace_destroy");
+	TRACE_BEGIN(WORKSPACE_DESTROY);
 	layout_workspace_destroy(wm, xcb_root);
+	TRACE_END(WORKSPACE_DESTROY);
 }
 
 void
 wm_workspace_next(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("workspace_next");
+	TRACE_BEGIN(WORKSPACE_NEXT);
 	layout_workspace_next(wm, xcb_root);
+	TRACE_END(WORKSPACE_NEXT);
 }
 
 void
 wm_workspace_prev(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("workspace_prev");
+	TRACE_BEGIN(WORKSPACE_PREV);
 	layout_workspace_prev(wm, xcb_root);
+	TRACE_END(WORKSPACE_PREV);
 }
 
 void
 wm_tile_split_h(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("tile_split_h");
+	TRACE_BEGIN(TILE_SPLIT);
 	layout_tile_split(wm, xcb_root, HSPLIT);
+	TRACE_END(TILE_SPLIT);
 }
 
 void
 wm_tile_split_v(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("tile_split_v");
+	TRACE_BEGIN(TILE_SPLIT);
 	layout_tile_split(wm, xcb_root, VSPLIT);
+	TRACE_END(TILE_SPLIT);
 }
 
 void
 wm_tile_next(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("tile_next");
+	TRACE_BEGIN(TILE_NEXT);
 	layout_tile_next(wm, xcb_root);
+	TRACE_END(TILE_NEXT);
 }
 
 void
 wm_tile_prev(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("tile_prev");
+	TRACE_BEGIN(TILE_PREV);
 	layout_tile_prev(wm, xcb_root);
+	TRACE_END(TILE_PREV);
 }
 
 void
 wm_tile_destroy(struct wm *wm, xcb_window_t xcb_root)
 {
 	log_debug("tile_destroy");
+	TRACE_BEGIN(TILE_DESTROY);
 	layout_tile_destroy(wm, xcb_root);
+	TRACE_END(TILE_DESTROY);
 }